@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "AvifCodec.h"
+#include <QColorSpace>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImageReader>
+#include <QMutex>
+#include <avif/avif.h>
+
+static constexpr int AVIF_ENCODER_THREADS = 2;
+static constexpr int SLOWEST_BUDGET_SPEED = 4;  // Slower libaom speeds gain little for their cost
+static constexpr int FASTEST_SPEED = 10;
+static constexpr double RATE_SMOOTHING = 0.2;   // Weight of the newest measurement
+static constexpr double BUDGET_MARGIN = 1.25;   // Headroom for content the rates have not seen
+
+// Measured encode cost per speed in microseconds per megapixel, shared by
+// all threads. Starts from rough libaom figures for two encoder threads and
+// follows what this machine actually does. A budget only ever picks speeds
+// predicted to fit, so a slow speed whose prior is too pessimistic would
+// never be tried; until a speed has been measured itself, its prior moves
+// by the same factor as each measured one.
+class SpeedRates {
+public:
+    double rate(int speed) const
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_rates[speed];
+    }
+
+    void record(int speed, qint64 pixels, qint64 elapsedUs)
+    {
+        if (pixels <= 0 || speed < 0 || speed > FASTEST_SPEED) return;
+        double measured = elapsedUs / (pixels / 1e6);
+        QMutexLocker lock(&m_mutex);
+        const double before = m_rates[speed];
+        m_rates[speed] += RATE_SMOOTHING * (measured - before);
+        m_measured[speed] = true;
+        const double factor = m_rates[speed] / before;
+        for (int other = 0; other <= FASTEST_SPEED; ++other) {
+            if (!m_measured[other]) m_rates[other] *= factor;
+        }
+    }
+
+private:
+    mutable QMutex m_mutex;
+    bool m_measured[FASTEST_SPEED + 1] = {};
+    double m_rates[FASTEST_SPEED + 1] = {
+        60e6, 40e6, 25e6, 12e6, 5e6, 3e6, 1.5e6, 0.8e6, 0.4e6, 0.25e6, 0.15e6
+    };
+};
+
+static SpeedRates &speedRates()
+{
+    static SpeedRates rates;
+    return rates;
+}
+
+// The YUV image a worker thread encodes from. Its planes are kept between
+// images and only reallocated when the size changes, so a batch of similar
+// images converts into the same buffers.
+class ThreadScratch {
+public:
+    ThreadScratch() = default;
+    ~ThreadScratch()
+    {
+        if (m_image) avifImageDestroy(m_image);
+    }
+
+    ThreadScratch(const ThreadScratch &) = delete;
+    ThreadScratch &operator=(const ThreadScratch &) = delete;
+
+    avifImage *imageFor(int width, int height)
+    {
+        if (!m_image) {
+            m_image = avifImageCreate(static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                                      8, AVIF_PIXEL_FORMAT_YUV420);
+        } else if (m_image->width != static_cast<uint32_t>(width)
+                   || m_image->height != static_cast<uint32_t>(height)) {
+            avifImageFreePlanes(m_image, AVIF_PLANES_ALL);
+            m_image->width = static_cast<uint32_t>(width);
+            m_image->height = static_cast<uint32_t>(height);
+        }
+        return m_image;
+    }
+
+private:
+    avifImage *m_image = nullptr;
+};
+
+static avifImage *threadImage(int width, int height)
+{
+    thread_local ThreadScratch scratch;
+    return scratch.imageFor(width, height);
+}
+
+// Describes img's pixels to libavif, converting only layouts it cannot read.
+// pixels keeps the converted copy alive while rgb points into it.
+static void describePixels(const QImage &img, QImage &pixels, avifRGBImage &rgb)
+{
+    pixels = img;
+    switch (pixels.format()) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // QImage's 32-bit formats are BGRA in memory on little-endian machines
+    case QImage::Format_RGB32:
+        rgb.format = AVIF_RGB_FORMAT_BGRA;
+        rgb.ignoreAlpha = AVIF_TRUE;
+        break;
+    case QImage::Format_ARGB32:
+        rgb.format = AVIF_RGB_FORMAT_BGRA;
+        break;
+    case QImage::Format_ARGB32_Premultiplied:
+        rgb.format = AVIF_RGB_FORMAT_BGRA;
+        rgb.alphaPremultiplied = AVIF_TRUE;
+        break;
+#endif
+    case QImage::Format_RGBX8888:
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        rgb.ignoreAlpha = AVIF_TRUE;
+        break;
+    case QImage::Format_RGBA8888:
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        break;
+    case QImage::Format_RGBA8888_Premultiplied:
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        rgb.alphaPremultiplied = AVIF_TRUE;
+        break;
+    case QImage::Format_RGB888:
+        rgb.format = AVIF_RGB_FORMAT_RGB;
+        break;
+    case QImage::Format_BGR888:
+        rgb.format = AVIF_RGB_FORMAT_BGR;
+        break;
+    default:
+        pixels = pixels.convertToFormat(QImage::Format_RGBA8888);
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        break;
+    }
+    rgb.depth = 8;
+    rgb.pixels = const_cast<uint8_t *>(pixels.constBits());
+    rgb.rowBytes = static_cast<uint32_t>(pixels.bytesPerLine());
+}
+
+int AvifCodec::speedFor(AvifSpeed speed)
+{
+    switch (speed) {
+    case AvifSpeed::Fast:     return 10;
+    case AvifSpeed::Balanced: return 8;
+    case AvifSpeed::Best:     return 6;
+    }
+    return 8;
+}
+
+int AvifCodec::speedForBudget(qint64 pixels, qint64 budgetUs, int encodes)
+{
+    const double megapixels = pixels / 1e6;
+    for (int speed = SLOWEST_BUDGET_SPEED; speed < FASTEST_SPEED; ++speed) {
+        if (speedRates().rate(speed) * megapixels * encodes * BUDGET_MARGIN <= budgetUs)
+            return speed;
+    }
+    return FASTEST_SPEED;
+}
+
+AvifCodec::Encoder::Encoder(const QImage &img, const ProcessingSettings &settings, int encodes)
+    : m_pixels(qint64(img.width()) * img.height())
+    , m_speed(settings.avifTimeBudgetMs > 0
+                  ? speedForBudget(m_pixels, qint64(settings.avifTimeBudgetMs) * 1000, encodes)
+                  : speedFor(settings.avifSpeed))
+{
+    avifImage *image = threadImage(img.width(), img.height());
+    if (!image) return;
+
+    avifRGBImage rgb;
+    avifRGBImageSetDefaults(&rgb, image);
+    QImage pixels;
+    describePixels(img, pixels, rgb);
+    // Planes left over from the thread's previous image must not leak into this one
+    if (rgb.ignoreAlpha || !pixels.hasAlphaChannel())
+        avifImageFreePlanes(image, AVIF_PLANES_A);
+
+    const QByteArray icc = img.colorSpace().isValid() ? img.colorSpace().iccProfile() : QByteArray();
+    if (avifImageSetProfileICC(image, reinterpret_cast<const uint8_t *>(icc.constData()),
+                               static_cast<size_t>(icc.size())) != AVIF_RESULT_OK)
+        return;
+    if (avifImageRGBToYUV(image, &rgb) != AVIF_RESULT_OK) return;
+    m_image = image;
+}
+
+bool AvifCodec::Encoder::encode(int quality, QByteArray &data, QString &errorMessage)
+{
+    avifEncoder *encoder = m_image ? avifEncoderCreate() : nullptr;
+    if (!encoder) {
+        errorMessage = "Failed to encode AVIF at quality " + QString::number(quality);
+        return false;
+    }
+    encoder->quality = quality;
+    encoder->qualityAlpha = quality;
+    encoder->speed = m_speed;
+    encoder->maxThreads = AVIF_ENCODER_THREADS;
+    encoder->autoTiling = AVIF_TRUE;
+
+    avifRWData output = AVIF_DATA_EMPTY;
+    QElapsedTimer clock;
+    clock.start();
+    avifResult result = avifEncoderWrite(encoder, m_image, &output);
+    avifEncoderDestroy(encoder);
+    if (result == AVIF_RESULT_OK) {
+        speedRates().record(m_speed, m_pixels, clock.nsecsElapsed() / 1000);
+        data = QByteArray(reinterpret_cast<const char *>(output.data), static_cast<qsizetype>(output.size));
+    }
+    avifRWDataFree(&output);
+    if (result != AVIF_RESULT_OK) {
+        errorMessage = "Failed to encode AVIF at quality " + QString::number(quality);
+        return false;
+    }
+    return true;
+}
+
+bool AvifCodec::isAvif(const QByteArray &data)
+{
+    avifROData header = { reinterpret_cast<const uint8_t *>(data.constData()), static_cast<size_t>(data.size()) };
+    return avifPeekCompatibleFileType(&header) == AVIF_TRUE;
+}
+
+QSize AvifCodec::peekSize(const QString &path)
+{
+    // Mapped through QFile rather than opened by libavif, whose narrow-char
+    // fopen cannot open every path on Windows; parsing only touches the
+    // header's pages
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return {};
+    const qint64 fileSize = file.size();
+    const uchar *bytes = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if (!bytes) return {};
+    avifDecoder *decoder = avifDecoderCreate();
+    if (!decoder) return {};
+    QSize size;
+    if (avifDecoderSetIOMemory(decoder, bytes, static_cast<size_t>(fileSize)) == AVIF_RESULT_OK
+        && avifDecoderParse(decoder) == AVIF_RESULT_OK)
+        size = QSize(static_cast<int>(decoder->image->width), static_cast<int>(decoder->image->height));
+    avifDecoderDestroy(decoder);
+    return size;
+}
+
+QImage AvifCodec::decode(const QByteArray &data, int threads)
+{
+    avifDecoder *decoder = avifDecoderCreate();
+    if (!decoder) return {};
+    decoder->maxThreads = qMax(1, threads);
+    // Only pixels and the colour profile are used
+    decoder->ignoreExif = AVIF_TRUE;
+    decoder->ignoreXMP = AVIF_TRUE;
+    // Same ceiling as Qt's readers, checked by libavif while parsing
+    if (QImageReader::allocationLimit() > 0) {
+        const qint64 maxPixels = qint64(QImageReader::allocationLimit()) * 1024 * 1024 / 4;
+        decoder->imageSizeLimit = static_cast<uint32_t>(qMin<qint64>(maxPixels, decoder->imageSizeLimit));
+    }
+
+    QImage qImg;
+    if (avifDecoderSetIOMemory(decoder, reinterpret_cast<const uint8_t *>(data.constData()),
+                               static_cast<size_t>(data.size())) == AVIF_RESULT_OK
+        && avifDecoderParse(decoder) == AVIF_RESULT_OK
+        && avifDecoderNextImage(decoder) == AVIF_RESULT_OK) {
+        const avifImage *image = decoder->image;
+        // Convert straight into the QImage in libyuv's native byte order,
+        // so its SIMD kernels need no swizzle and there is no copy after.
+        // Opaque images get a layout that says so.
+        const bool hasAlpha = image->alphaPlane != nullptr;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        qImg = QImage(static_cast<int>(image->width), static_cast<int>(image->height),
+                      hasAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+#else
+        qImg = QImage(static_cast<int>(image->width), static_cast<int>(image->height),
+                      hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888);
+#endif
+        avifRGBImage rgb;
+        avifRGBImageSetDefaults(&rgb, image);
+        rgb.format = (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) ? AVIF_RGB_FORMAT_BGRA : AVIF_RGB_FORMAT_RGBA;
+        rgb.depth = 8;
+        rgb.maxThreads = decoder->maxThreads;
+        rgb.pixels = qImg.bits();
+        rgb.rowBytes = static_cast<uint32_t>(qImg.bytesPerLine());
+        if (qImg.isNull() || avifImageYUVToRGB(image, &rgb) != AVIF_RESULT_OK)
+            qImg = QImage();
+        else if (image->icc.size > 0)
+            qImg.setColorSpace(QColorSpace::fromIccProfile(
+                QByteArray(reinterpret_cast<const char *>(image->icc.data), static_cast<qsizetype>(image->icc.size))));
+    }
+    avifDecoderDestroy(decoder);
+    return qImg;
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+#include "ProcessingJob.h"
+
+struct avifImage;
+
+// AVIF decode and encode on libavif/libaom
+class AvifCodec {
+public:
+    // True if data starts with an AVIF file type box
+    static bool isAvif(const QByteArray &data);
+    // Dimensions of the AVIF file at path, read from its header alone;
+    // invalid if it is not an AVIF
+    static QSize peekSize(const QString &path);
+    // Decodes on up to `threads` threads into RGB32, or ARGB32 when the
+    // image has alpha. Images over QImageReader's allocation limit are
+    // rejected from their header, before any pixels are allocated.
+    static QImage decode(const QByteArray &data, int threads);
+    static int speedFor(AvifSpeed speed);
+    // The slowest speed predicted to finish `encodes` encodes of an image
+    // this size within budgetUs, from the encode times measured so far in
+    // this process; the fastest speed if none fits
+    static int speedForBudget(qint64 pixels, qint64 budgetUs, int encodes);
+
+    // One image converted to YUV once, then encoded at as many qualities as
+    // a target-size search needs. The YUV planes belong to the calling
+    // thread and are reused by its next image, so only one Encoder may be
+    // alive per thread. With a time budget the speed is chosen up front for
+    // all of them.
+    class Encoder {
+    public:
+        Encoder(const QImage &img, const ProcessingSettings &settings, int encodes = 1);
+
+        Encoder(const Encoder &) = delete;
+        Encoder &operator=(const Encoder &) = delete;
+
+        bool isValid() const { return m_image != nullptr; }
+        int speed() const { return m_speed; }
+        bool encode(int quality, QByteArray &data, QString &errorMessage);
+
+    private:
+        avifImage *m_image = nullptr;
+        qint64 m_pixels;
+        int m_speed;
+    };
+};
@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "BatchJournal.h"
+#include "ReportWriter.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QThread>
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static constexpr int SYNC_INTERVAL_MS = 1000;  // Longest a finished job can go unrecorded on disk
+static constexpr qsizetype QUEUED_PER_LINE = 1000;
+
+static QJsonObject settingsToJson(const ProcessingSettings &s)
+{
+    QJsonObject obj;
+    obj["format"] = static_cast<int>(s.format);
+    obj["resizeMode"] = static_cast<int>(s.resizeMode);
+    obj["resizePercent"] = s.resizePercent;
+    obj["resizeWidth"] = s.resizeWidth;
+    obj["resizeHeight"] = s.resizeHeight;
+    obj["quality"] = s.quality;
+    obj["useTargetSize"] = s.useTargetSize;
+    obj["targetSizeKB"] = s.targetSizeKB;
+    obj["jpegSubsampling"] = static_cast<int>(s.jpegSubsampling);
+    obj["jpegOptimizeCoding"] = s.jpegOptimizeCoding;
+    obj["jpegProgressive"] = s.jpegProgressive;
+    obj["jpegFastDct"] = s.jpegFastDct;
+    obj["webpSpeed"] = static_cast<int>(s.webpSpeed);
+    obj["avifSpeed"] = static_cast<int>(s.avifSpeed);
+    obj["avifTimeBudgetMs"] = s.avifTimeBudgetMs;
+    obj["passthrough"] = static_cast<int>(s.passthrough);
+    obj["neverLarger"] = s.neverLarger;
+    return obj;
+}
+
+static std::shared_ptr<ProcessingSettings> settingsFromJson(const QJsonObject &obj)
+{
+    auto s = std::make_shared<ProcessingSettings>();
+    s->format = static_cast<OutputFormat>(obj["format"].toInt());
+    s->resizeMode = static_cast<ResizeMode>(obj["resizeMode"].toInt());
+    s->resizePercent = obj["resizePercent"].toInt(100);
+    s->resizeWidth = obj["resizeWidth"].toInt();
+    s->resizeHeight = obj["resizeHeight"].toInt();
+    s->quality = obj["quality"].toInt(85);
+    s->useTargetSize = obj["useTargetSize"].toBool();
+    s->targetSizeKB = obj["targetSizeKB"].toInteger(500);
+    s->jpegSubsampling = static_cast<JpegSubsampling>(obj["jpegSubsampling"].toInt());
+    s->jpegOptimizeCoding = obj["jpegOptimizeCoding"].toBool(true);
+    s->jpegProgressive = obj["jpegProgressive"].toBool();
+    s->jpegFastDct = obj["jpegFastDct"].toBool();
+    s->webpSpeed = static_cast<WebpSpeed>(obj["webpSpeed"].toInt(static_cast<int>(WebpSpeed::Balanced)));
+    s->avifSpeed = static_cast<AvifSpeed>(obj["avifSpeed"].toInt(static_cast<int>(AvifSpeed::Balanced)));
+    s->avifTimeBudgetMs = obj["avifTimeBudgetMs"].toInt();
+    s->passthrough = static_cast<Passthrough>(obj["passthrough"].toInt());
+    s->neverLarger = obj["neverLarger"].toBool();
+    return s;
+}
+
+static QByteArray jsonLine(const QJsonObject &obj)
+{
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact) + '\n';
+}
+
+static void syncToDisk(QFile &file)
+{
+    file.flush();
+#if defined(Q_OS_WIN)
+    _commit(file.handle());
+#else
+    ::fsync(file.handle());
+#endif
+}
+
+BatchJournal::BatchJournal() = default;
+
+BatchJournal::~BatchJournal()
+{
+    stopWriter();
+}
+
+QString BatchJournal::defaultPath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+        .filePath("batch-journal.jsonl");
+}
+
+QString BatchJournal::settingsHash(const ProcessingSettings &settings)
+{
+    QByteArray digest = QCryptographicHash::hash(
+        QJsonDocument(settingsToJson(settings)).toJson(QJsonDocument::Compact), QCryptographicHash::Sha1);
+    return QString::fromLatin1(digest.left(8).toHex());
+}
+
+QString BatchJournal::doneKey(const QString &settingsHash, const QString &inputPath)
+{
+    return settingsHash + '|' + inputPath;
+}
+
+bool BatchJournal::load(const QString &path, State &state)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    bool completed = false;
+    while (!file.atEnd()) {
+        // A line cut short by a crash does not parse and is skipped
+        QJsonObject obj = QJsonDocument::fromJson(file.readLine()).object();
+        if (obj.isEmpty()) continue;
+        if (obj.contains("done")) {
+            QString status = obj["status"].toString();
+            // Saving can fail for passing reasons (disk full); rerun those
+            if (status == ReportWriter::statusName(ResultStatus::Success)
+                || status == ReportWriter::statusName(ResultStatus::KeptOriginal)
+                || status == ReportWriter::statusName(ResultStatus::FailedToLoad))
+                state.finished.insert(doneKey(obj["hash"].toString(), obj["done"].toString()));
+        } else if (obj.contains("queued")) {
+            const QJsonArray paths = obj["queued"].toArray();
+            for (const QJsonValue &p : paths)
+                state.queued << p.toString();
+        } else if (obj.contains("journal")) {
+            state.settings = settingsFromJson(obj["settings"].toObject());
+            state.outputDir = obj["outputDir"].toString();
+            state.manifestPath = obj["manifest"].toString();
+        } else if (obj.contains("end")) {
+            completed = obj["end"].toString() == "completed";
+            continue;
+        }
+        completed = false;
+    }
+    return state.settings && !completed && (!state.manifestPath.isEmpty() || !state.queued.isEmpty());
+}
+
+bool BatchJournal::create(const QString &path, const ProcessingSettings &settings,
+                          const QString &outputDir, const QString &manifestPath)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    QJsonObject header;
+    header["journal"] = 1;
+    header["settings"] = settingsToJson(settings);
+    header["outputDir"] = outputDir;
+    if (!manifestPath.isEmpty())
+        header["manifest"] = manifestPath;
+    m_lines = jsonLine(header);
+    startWriter();
+    flush();
+    return true;
+}
+
+bool BatchJournal::reopen(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) return false;
+    startWriter();
+    return true;
+}
+
+void BatchJournal::startWriter()
+{
+    m_lastSettings = nullptr;
+    m_stopping = false;
+    m_pending.clear();
+    m_writer.reset(QThread::create([this]() { writerLoop(); }));
+    m_writer->start(QThread::LowPriority);
+}
+
+void BatchJournal::noteQueued(const QStringList &paths)
+{
+    if (!isOpen()) return;
+    for (qsizetype start = 0; start < paths.size(); start += QUEUED_PER_LINE) {
+        QJsonObject obj;
+        obj["queued"] = QJsonArray::fromStringList(paths.mid(start, QUEUED_PER_LINE));
+        m_lines += jsonLine(obj);
+    }
+    flush();
+}
+
+void BatchJournal::consume(const ProcessingResult &result)
+{
+    if (!isOpen() || !result.settings) return;
+    // Results of a batch almost always share one settings object
+    if (result.settings.get() != m_lastSettings) {
+        m_lastSettings = result.settings.get();
+        m_lastHash = settingsHash(*result.settings);
+    }
+    QJsonObject obj;
+    obj["done"] = result.inputPath;
+    obj["status"] = ReportWriter::statusName(result.status);
+    obj["hash"] = m_lastHash;
+    m_lines += jsonLine(obj);
+}
+
+void BatchJournal::flush()
+{
+    if (m_lines.isEmpty()) return;
+    QMutexLocker lock(&m_mutex);
+    m_pending += m_lines;
+    m_lines.clear();
+}
+
+void BatchJournal::finish(bool cancelled)
+{
+    if (!isOpen()) return;
+    QJsonObject end;
+    end["end"] = cancelled ? "cancelled" : "completed";
+    m_lines += jsonLine(end);
+    flush();
+    stopWriter();
+    m_file.close();
+    // Nothing is left to resume
+    if (!cancelled)
+        m_file.remove();
+}
+
+void BatchJournal::stopWriter()
+{
+    if (!m_writer) return;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_writer->wait();
+    m_writer.reset();
+}
+
+void BatchJournal::writerLoop()
+{
+    QMutexLocker lock(&m_mutex);
+    for (;;) {
+        if (!m_stopping)
+            m_wake.wait(&m_mutex, SYNC_INTERVAL_MS);
+        QByteArray chunk;
+        chunk.swap(m_pending);
+        bool stopping = m_stopping;
+        lock.unlock();
+
+        // One write and one fsync per interval, however many jobs finished
+        if (!chunk.isEmpty()) {
+            m_file.write(chunk);
+            syncToDisk(m_file);
+        }
+
+        lock.relock();
+        if (stopping && m_pending.isEmpty()) return;
+    }
+}
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <memory>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QWaitCondition>
+
+#include "ProcessingJob.h"
+#include "ResultSink.h"
+
+class QThread;
+
+// Append-only JSON Lines record of a batch: its settings and inputs, then
+// one line per finished job with the job's settings hash. A journal that
+// does not end in a "completed" line belongs to a batch that was closed or
+// crashed, and can be resumed. The GUI thread only formats lines; a writer
+// thread appends them and fsyncs at most once per interval, so journaling
+// costs a few microseconds per result.
+class BatchJournal : public ResultSink {
+public:
+    // An interrupted batch, read back from its journal
+    struct State {
+        std::shared_ptr<ProcessingSettings> settings;
+        QString outputDir;      // Empty: "resized" next to each input
+        QString manifestPath;   // Empty: the inputs are the queued paths
+        QStringList queued;
+        QSet<QString> finished; // doneKey() of jobs that need no rerun
+    };
+
+    BatchJournal();
+    ~BatchJournal() override;
+
+    static QString defaultPath();
+    static QString settingsHash(const ProcessingSettings &settings);
+    static QString doneKey(const QString &settingsHash, const QString &inputPath);
+    // False if the journal is missing, unreadable or its batch completed
+    static bool load(const QString &path, State &state);
+
+    // Starts a journal for a new batch, replacing any previous one
+    bool create(const QString &path, const ProcessingSettings &settings,
+                const QString &outputDir, const QString &manifestPath);
+    // Continues the journal of an interrupted batch
+    bool reopen(const QString &path);
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // Inputs of a table batch, recorded so a resume does not need the table
+    void noteQueued(const QStringList &paths);
+
+    void consume(const ProcessingResult &result) override;
+    void flush() override;
+    // Closes the journal, deleting it if the batch completed
+    void finish(bool cancelled) override;
+
+private:
+    void startWriter();
+    void writerLoop();
+    void stopWriter();
+
+    QFile m_file;
+    QByteArray m_lines;                         // GUI thread, handed over on flush()
+    const ProcessingSettings *m_lastSettings = nullptr;
+    QString m_lastHash;
+
+    std::unique_ptr<QThread> m_writer;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QByteArray m_pending;                       // Guarded by m_mutex
+    bool m_stopping = false;                    // Guarded by m_mutex
+};
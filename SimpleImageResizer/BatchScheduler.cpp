@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "BatchScheduler.h"
+#include "ImageProcessor.h"
+#include "ResultDispatcher.h"
+#include "WorkerProcess.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+
+static constexpr int LOOKAHEAD_WINDOW = 256;  // Entries ordered by cost ahead of the workers
+static constexpr quint64 RESCORE_EVERY = 8;   // Finished jobs between re-estimates of the window
+
+BatchScheduler::BatchScheduler(QThreadPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_pool(pool)
+{
+}
+
+BatchScheduler::~BatchScheduler()
+{
+    cancel();
+    waitForDone();
+}
+
+void BatchScheduler::start(std::shared_ptr<JobSource> source,
+                           std::shared_ptr<const ProcessingSettings> settings,
+                           const QString &outputDir, ResultDispatcher *dispatcher,
+                           int ioLimit, int cpuLimit, bool isolated)
+{
+    waitForDone();
+    m_source = std::move(source);
+    m_settings = std::move(settings);
+    m_outputDir = outputDir;
+    m_dispatcher = dispatcher;
+    m_limiter = std::make_unique<ConcurrencyLimiter>(ioLimit, cpuLimit);
+    m_cancelled = false;
+    m_isolated = isolated;
+    m_planner = OutputPathPlanner();
+    m_unwritten.clear();
+    m_replan = false;
+    m_lookahead.clear();
+    m_priority.clear();
+    m_nextIndex = 0;
+    m_scoredVersion = m_costModel.version();
+
+    // Workers wait on the limiter's slots, so there must be enough of them
+    // to reach both limits. Isolated workers each drive one child process,
+    // which does its own I/O, so only the CPU limit applies.
+    int workerCount = m_isolated ? qMax(1, cpuLimit) : m_limiter->threadCount();
+    m_pool->setMaxThreadCount(workerCount);
+    m_activeWorkers = workerCount;
+    m_workers.clear();
+    for (int i = 0; i < workerCount; ++i)
+        m_workers << QtConcurrent::run(m_pool, [this]() { workerLoop(); });
+}
+
+void BatchScheduler::cancel()
+{
+    m_cancelled = true;
+    if (m_source) m_source->cancel();
+}
+
+void BatchScheduler::waitForDone()
+{
+    for (QFuture<void> &worker : m_workers)
+        worker.waitForFinished();
+    m_workers.clear();
+}
+
+double BatchScheduler::estimate(const Pending &pending) const
+{
+    // Unreadable entries fail at once; run them first so they report early
+    if (!pending.entry.error.isEmpty()) return std::numeric_limits<double>::max();
+    const ProcessingSettings &settings = pending.entry.settings ? *pending.entry.settings : *m_settings;
+    return m_costModel.estimate(pending.kind, pending.entry.fileSize, pending.entry.pixels, settings);
+}
+
+void BatchScheduler::rescoreIfStale()
+{
+    quint64 version = m_costModel.version();
+    if (version - m_scoredVersion < RESCORE_EVERY) return;
+    m_scoredVersion = version;
+    for (Pending &pending : m_lookahead)
+        pending.cost = estimate(pending);
+    std::make_heap(m_lookahead.begin(), m_lookahead.end(), cheaper);
+}
+
+// Called with m_sourceMutex held but not m_lookaheadMutex, so the stat
+// never holds up workers taking entries already in the window
+BatchScheduler::Pending BatchScheduler::makePending(JobEntry entry)
+{
+    Pending pending;
+    pending.entry = std::move(entry);
+    if (pending.entry.index < 0)
+        pending.entry.index = m_nextIndex;
+    ++m_nextIndex;
+    if (pending.entry.error.isEmpty()) {
+        pending.kind = CostModel::inputKind(pending.entry.inputPath);
+        if (pending.entry.fileSize < 0)
+            pending.entry.fileSize = QFileInfo(pending.entry.inputPath).size();
+    }
+    pending.cost = estimate(pending);
+    return pending;
+}
+
+int BatchScheduler::prioritize(const QList<qint64> &indexes)
+{
+    QStringList hints;
+    int found = 0;
+    {
+        // The source lock first, so no entry is between the source and the window
+        QMutexLocker sourceLock(&m_sourceMutex);
+        QMutexLocker lock(&m_lookaheadMutex);
+        if (!m_source) return 0;
+        for (qint64 index : indexes) {
+            auto it = std::find_if(m_lookahead.begin(), m_lookahead.end(),
+                                   [index](const Pending &p) { return p.entry.index == index; });
+            JobEntry entry;
+            if (it != m_lookahead.end()) {
+                entry = std::move(it->entry);
+                m_lookahead.erase(it);
+                std::make_heap(m_lookahead.begin(), m_lookahead.end(), cheaper);
+            } else if (!m_source->withdraw(index, entry)) {
+                continue;
+            }
+            if (entry.error.isEmpty())
+                hints << entry.inputPath;
+            m_priority.push_back(std::move(entry));
+            ++found;
+        }
+    }
+    // Hinting opens each file, so it waits until the locks are released
+    adviseWillNeed(hints);
+    return found;
+}
+
+void BatchScheduler::adviseWillNeed(const QStringList &paths)
+{
+    for (const QString &path : paths)
+        ConcurrencyLimiter::adviseWillNeed(path);
+}
+
+// Tops the window up from the source. Called with m_sourceMutex held.
+JobSource::Status BatchScheduler::refill()
+{
+    int wanted;
+    {
+        QMutexLocker lock(&m_lookaheadMutex);
+        wanted = LOOKAHEAD_WINDOW - static_cast<int>(m_lookahead.size());
+    }
+    JobSource::Status status = JobSource::Status::Ready;
+    std::vector<Pending> fetched;
+    while (static_cast<int>(fetched.size()) < wanted) {
+        JobEntry upcoming;
+        status = m_source->next(upcoming);
+        if (status != JobSource::Status::Ready) break;
+        fetched.push_back(makePending(std::move(upcoming)));
+    }
+    if (fetched.empty()) return status;
+
+    QMutexLocker lock(&m_lookaheadMutex);
+    for (Pending &pending : fetched) {
+        m_lookahead.push_back(std::move(pending));
+        std::push_heap(m_lookahead.begin(), m_lookahead.end(), cheaper);
+    }
+    return status;
+}
+
+// Called with m_lookaheadMutex held and the window not empty. Adds the
+// inputs to hint to the OS to hints, for the caller to pass on unlocked.
+void BatchScheduler::takeCostliest(JobEntry &entry, QStringList &hints)
+{
+    rescoreIfStale();
+
+    std::pop_heap(m_lookahead.begin(), m_lookahead.end(), cheaper);
+    Pending &taken = m_lookahead.back();
+    if (!taken.hinted && taken.entry.error.isEmpty())
+        hints << taken.entry.inputPath;
+    entry = std::move(taken.entry);
+    m_lookahead.pop_back();
+
+    if (!m_lookahead.empty()) {
+        Pending &next = m_lookahead.front();
+        if (!next.hinted && next.entry.error.isEmpty())
+            hints << next.entry.inputPath;
+        next.hinted = true;
+    }
+}
+
+JobSource::Status BatchScheduler::take(JobEntry &entry)
+{
+    QStringList hints;
+    const JobSource::Status status = pick(entry, hints);
+    adviseWillNeed(hints);
+    return status;
+}
+
+// take() minus the OS hints, which are added to hints for take() to pass on
+JobSource::Status BatchScheduler::pick(JobEntry &entry, QStringList &hints)
+{
+    for (;;) {
+        {
+            QMutexLocker lock(&m_lookaheadMutex);
+            if (!m_priority.empty()) {
+                entry = std::move(m_priority.front());
+                m_priority.pop_front();
+                return JobSource::Status::Ready;
+            }
+            if (static_cast<int>(m_lookahead.size()) >= LOOKAHEAD_WINDOW) {
+                takeCostliest(entry, hints);
+                return JobSource::Status::Ready;
+            }
+        }
+
+        // One worker refills at a time; the others keep taking from the window
+        JobSource::Status status;
+        if (m_sourceMutex.tryLock()) {
+            status = refill();
+            m_sourceMutex.unlock();
+        } else {
+            {
+                QMutexLocker lock(&m_lookaheadMutex);
+                if (!m_lookahead.empty()) {
+                    takeCostliest(entry, hints);
+                    return JobSource::Status::Ready;
+                }
+            }
+            // The window is dry: wait for the refill in progress, then try the source
+            QMutexLocker sourceLock(&m_sourceMutex);
+            status = refill();
+        }
+
+        QMutexLocker lock(&m_lookaheadMutex);
+        if (!m_lookahead.empty()) {
+            takeCostliest(entry, hints);
+            return JobSource::Status::Ready;
+        }
+        if (status != JobSource::Status::Ready) return status;
+        // Other workers emptied the window since the refill; go round again
+    }
+}
+
+bool BatchScheduler::prepareJob(const JobEntry &entry, ProcessingJob &job, ProcessingResult &failure)
+{
+    job.inputPath = entry.inputPath;
+    job.settings = entry.settings ? entry.settings : m_settings;
+    job.cancelFlag = &m_cancelled;
+    job.limiter = m_limiter.get();
+    job.decodeThreads = m_limiter->threadsPerJob();
+    job.index = entry.index;
+
+    failure.inputPath = entry.inputPath;
+    failure.index = job.index;
+    failure.settings = job.settings;
+    if (!entry.error.isEmpty()) {
+        failure.status = ResultStatus::FailedToLoad;
+        failure.errorMessage = entry.error;
+        return false;
+    }
+
+    QString dir = !entry.outputDir.isEmpty() ? entry.outputDir
+                : !m_outputDir.isEmpty()     ? m_outputDir
+                : QFileInfo(entry.inputPath).dir().filePath("resized");
+
+    // Planning is in-memory after a directory's first listing, so one lock is enough
+    QMutexLocker lock(&m_plannerMutex);
+    if (m_replan.exchange(false)) {
+        m_planner = OutputPathPlanner();
+        for (const PlannedOutput &output : std::as_const(m_unwritten))
+            m_planner.reserve(output.stem, output.exts);
+    }
+    if (!m_planner.ensureDirectory(dir)) {
+        failure.status = ResultStatus::FailedToSave;
+        failure.errorMessage = "Could not create output directory: " + dir;
+        return false;
+    }
+    job.outputDir = dir;
+    const OutputFormat format = job.settings->format;
+    const QStringList exts = ImageProcessor::possibleExtensions(format);
+    const QString stem = m_planner.plan(entry.inputPath, dir, exts);
+    job.outputPath = stem + ImageProcessor::formatExtension(format);
+    m_unwritten.insert(job.index, PlannedOutput{stem, exts});
+    return true;
+}
+
+void BatchScheduler::jobWritten(qint64 index)
+{
+    QMutexLocker lock(&m_plannerMutex);
+    m_unwritten.remove(index);
+}
+
+void BatchScheduler::replan()
+{
+    m_replan = true;
+}
+
+void BatchScheduler::workerLoop()
+{
+    std::unique_ptr<WorkerProcess> child;
+    if (m_isolated) child = std::make_unique<WorkerProcess>();
+
+    JobEntry entry;
+    while (!m_cancelled.load(std::memory_order_relaxed)) {
+        JobSource::Status status = take(entry);
+        if (status == JobSource::Status::Exhausted) break;
+        if (status == JobSource::Status::Waiting) {
+            m_source->waitForMore(100);
+            continue;
+        }
+
+        ProcessingJob job;
+        ProcessingResult failure;
+        if (prepareJob(entry, job, failure)) {
+            ProcessingResult result = child ? child->process(job) : ImageProcessor::process(job);
+            jobWritten(job.index);
+            result.settings = job.settings;
+            m_costModel.record(*job.settings, result);
+            m_dispatcher->push(std::move(result));
+        } else {
+            m_dispatcher->push(std::move(failure));
+        }
+    }
+
+    child.reset();
+    if (m_activeWorkers.fetch_sub(1) == 1) {
+        bool cancelled = m_cancelled.load();
+        QMetaObject::invokeMethod(this, [this, cancelled]() { emit finished(cancelled); },
+                                  Qt::QueuedConnection);
+    }
+}
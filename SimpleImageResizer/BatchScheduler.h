@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+#include "ConcurrencyLimiter.h"
+#include "CostModel.h"
+#include "JobSource.h"
+#include "OutputPathPlanner.h"
+
+class QThreadPool;
+class ResultDispatcher;
+
+// Runs a batch by pulling work from a JobSource. One worker loop per pool
+// thread takes the next entry as soon as it is free, plans its output path
+// and processes it, so the first image starts without waiting for the rest
+// of the batch to be listed and nothing per job outlives the job itself.
+//
+// Entries wait in a lookahead window ordered by estimated cost, and a free
+// worker always takes the most expensive one (longest processing time
+// first), so big RAW or AVIF jobs do not end up alone at the tail of the
+// batch. Workers share the window rather than owning queues, which balances
+// the remainder the way work stealing would. Each result keeps the index
+// of its entry in source order. Results go to the dispatcher.
+//
+// Entries can be prioritized while the batch runs: they leave the window
+// (or the source) for a priority lane that the next free worker empties
+// first.
+class BatchScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BatchScheduler(QThreadPool *pool, QObject *parent = nullptr);
+    ~BatchScheduler() override;
+
+    // outputDir empty: each output goes to a "resized" folder next to its input.
+    // isolated: each worker hands its jobs to a WorkerProcess, one per CPU slot.
+    void start(std::shared_ptr<JobSource> source, std::shared_ptr<const ProcessingSettings> settings,
+               const QString &outputDir, ResultDispatcher *dispatcher, int ioLimit, int cpuLimit,
+               bool isolated = false);
+    void cancel();
+    void waitForDone();
+
+    // Makes the next job planned re-list its output directory and forget
+    // the outputs already written, for a batch that runs indefinitely while
+    // other programs change its output folders. Outputs still being
+    // processed stay reserved.
+    void replan();
+
+    // Runs the entries with these source indexes on the next free workers.
+    // Returns how many were still waiting; the rest are running or done.
+    int prioritize(const QList<qint64> &indexes);
+    bool isRunning() const { return m_activeWorkers.load() > 0; }
+
+signals:
+    // Emitted on the scheduler's thread once every worker has stopped
+    void finished(bool cancelled);
+
+private:
+    struct Pending {
+        JobEntry entry;
+        CostModel::InputKind kind = CostModel::InputKind::Other;
+        double cost = 0;
+        bool hinted = false;
+    };
+
+    static bool cheaper(const Pending &a, const Pending &b) { return a.cost < b.cost; }
+
+    void workerLoop();
+    JobSource::Status take(JobEntry &entry);
+    JobSource::Status pick(JobEntry &entry, QStringList &hints);
+    JobSource::Status refill();
+    void takeCostliest(JobEntry &entry, QStringList &hints);
+    static void adviseWillNeed(const QStringList &paths);
+    Pending makePending(JobEntry entry);
+    double estimate(const Pending &pending) const;
+    void rescoreIfStale();
+    bool prepareJob(const JobEntry &entry, ProcessingJob &job, ProcessingResult &failure);
+    void jobWritten(qint64 index);
+
+    QThreadPool *m_pool;
+    std::shared_ptr<JobSource> m_source;
+    std::shared_ptr<const ProcessingSettings> m_settings;
+    QString m_outputDir;
+    ResultDispatcher *m_dispatcher = nullptr;
+    std::unique_ptr<ConcurrencyLimiter> m_limiter;
+    std::atomic<bool> m_cancelled{false};
+    bool m_isolated = false;
+
+    struct PlannedOutput {
+        QString stem;
+        QStringList exts;
+    };
+
+    QMutex m_plannerMutex;
+    OutputPathPlanner m_planner;
+    QHash<qint64, PlannedOutput> m_unwritten;  // Planned outputs of running jobs, by index
+    std::atomic<bool> m_replan{false};
+
+    // Entries taken from the source but not yet started, as a max-heap on
+    // cost. The next entry to run has its input hinted to the OS so the read
+    // overlaps with the jobs ahead of it. m_sourceMutex serialises refills,
+    // which read the source and stat new entries without m_lookaheadMutex;
+    // when both are held it is taken first.
+    QMutex m_sourceMutex;
+    QMutex m_lookaheadMutex;
+    std::vector<Pending> m_lookahead;
+    std::deque<JobEntry> m_priority;  // Prioritized entries, taken before the window
+    qint64 m_nextIndex = 0;  // Guarded by m_sourceMutex
+    CostModel m_costModel;
+    quint64 m_scoredVersion = 0;  // Cost model version the heap was ordered with
+
+    std::atomic<int> m_activeWorkers{0};
+    QList<QFuture<void>> m_workers;
+};
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "BatchStats.h"
+
+void BatchStats::begin()
+{
+    *this = BatchStats();
+}
+
+void BatchStats::consume(const ProcessingResult &result)
+{
+    switch (result.status) {
+    case ResultStatus::Success:
+    case ResultStatus::KeptOriginal:
+        ++m_succeeded;
+        m_originalBytes += result.originalSize;
+        m_newBytes += result.newSize;
+        break;
+    case ResultStatus::Cancelled:
+        ++m_cancelled;
+        break;
+    default:
+        ++m_failed;
+        break;
+    }
+}
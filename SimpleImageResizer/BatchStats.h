@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include "ResultSink.h"
+
+// Running totals for the current batch; keeps no per-file state.
+class BatchStats : public ResultSink {
+public:
+    void begin() override;
+    void consume(const ProcessingResult &result) override;
+
+    int completed() const { return m_succeeded + m_failed + m_cancelled; }
+    int succeeded() const { return m_succeeded; }
+    int failed() const { return m_failed; }
+    int cancelled() const { return m_cancelled; }
+    qint64 originalBytes() const { return m_originalBytes; }  // Successful files only
+    qint64 newBytes() const { return m_newBytes; }
+
+private:
+    int m_succeeded = 0;
+    int m_failed = 0;
+    int m_cancelled = 0;
+    qint64 m_originalBytes = 0;
+    qint64 m_newBytes = 0;
+};
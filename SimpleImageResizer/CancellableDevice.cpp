@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "CancellableDevice.h"
+
+CancellableDevice::CancellableDevice(QIODevice *inner, const std::atomic<bool> *cancelFlag, qint64 maxBytes)
+    : m_inner(inner)
+    , m_cancelFlag(cancelFlag)
+    , m_maxBytes(maxBytes)
+{
+    // Unbuffered so the position always matches the inner device's
+    QIODevice::open(inner->openMode() | QIODevice::Unbuffered);
+    QIODevice::seek(inner->pos());
+}
+
+bool CancellableDevice::seek(qint64 pos)
+{
+    return QIODevice::seek(pos) && m_inner->seek(pos);
+}
+
+qint64 CancellableDevice::readData(char *data, qint64 maxSize)
+{
+    if (cancelled()) {
+        setErrorString("Cancelled");
+        return -1;
+    }
+    return m_inner->read(data, maxSize);
+}
+
+qint64 CancellableDevice::writeData(const char *data, qint64 maxSize)
+{
+    if (cancelled()) {
+        setErrorString("Cancelled");
+        return -1;
+    }
+    if (m_maxBytes > 0 && pos() + maxSize > m_maxBytes) {
+        m_overLimit = true;
+        setErrorString("Output larger than the limit");
+        return -1;
+    }
+    return m_inner->write(data, maxSize);
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <QIODevice>
+
+// Pass-through device that fails every read and write once the cancel flag
+// is raised. Qt's image handlers stream through their device in small
+// blocks, so wrapping the buffer makes a long JPEG/PNG decode or encode stop
+// within one block instead of running to completion. A write limit ends an
+// encode the same way as soon as its output grows past maxBytes.
+class CancellableDevice : public QIODevice {
+public:
+    // inner must already be open and outlive this device; maxBytes <= 0
+    // leaves writes unlimited
+    CancellableDevice(QIODevice *inner, const std::atomic<bool> *cancelFlag, qint64 maxBytes = 0);
+
+    bool isSequential() const override { return m_inner->isSequential(); }
+    qint64 size() const override { return m_inner->size(); }
+    bool seek(qint64 pos) override;
+
+    bool cancelled() const { return m_cancelFlag && m_cancelFlag->load(std::memory_order_relaxed); }
+    bool overLimit() const { return m_overLimit; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QIODevice *m_inner;
+    const std::atomic<bool> *m_cancelFlag;
+    qint64 m_maxBytes;
+    bool m_overLimit = false;
+};
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ConcurrencyLimiter.h"
+#include <QFile>
+#include <QThread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ConcurrencyLimiter::ConcurrencyLimiter(int ioLimit, int cpuLimit)
+    : m_ioLimit(qMax(1, ioLimit))
+    , m_cpuLimit(qMax(1, cpuLimit))
+    , m_ioSlots(m_ioLimit)
+    , m_cpuSlots(m_cpuLimit)
+{
+}
+
+int ConcurrencyLimiter::threadsPerJob() const
+{
+    return qMax(1, QThread::idealThreadCount() / m_cpuLimit);
+}
+
+bool ConcurrencyLimiter::acquire(QSemaphore &sem, const std::atomic<bool> *cancelFlag)
+{
+    // Poll in short slices so a cancelled batch does not stay parked behind
+    // slow reads or long encodes held by other workers
+    while (!sem.tryAcquire(1, 50)) {
+        if (cancelFlag && cancelFlag->load(std::memory_order_relaxed))
+            return false;
+    }
+    return true;
+}
+
+bool ConcurrencyLimiter::acquireIo(const std::atomic<bool> *cancelFlag)
+{
+    return acquire(m_ioSlots, cancelFlag);
+}
+
+void ConcurrencyLimiter::releaseIo()
+{
+    m_ioSlots.release();
+}
+
+bool ConcurrencyLimiter::acquireCpu(const std::atomic<bool> *cancelFlag)
+{
+    return acquire(m_cpuSlots, cancelFlag);
+}
+
+void ConcurrencyLimiter::releaseCpu()
+{
+    m_cpuSlots.release();
+}
+
+void ConcurrencyLimiter::adviseWillNeed(const QString &path)
+{
+#if defined(__linux__)
+    // Starts asynchronous readahead; the page cache keeps the data after close
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    Q_UNUSED(path);
+#endif
+}
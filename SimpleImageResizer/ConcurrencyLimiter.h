@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <QSemaphore>
+#include <QString>
+
+// Bounds how many jobs may touch storage (read input / write output) and how
+// many may run CPU-heavy work (decode, resize, encode) at the same time.
+// Slow network shares want many files in flight with few encodes; fast local
+// disks on many-core machines want the opposite.
+class ConcurrencyLimiter {
+public:
+    ConcurrencyLimiter(int ioLimit, int cpuLimit);
+
+    int ioLimit() const { return m_ioLimit; }
+    int cpuLimit() const { return m_cpuLimit; }
+
+    // Worker threads needed so that both limits can actually be reached
+    int threadCount() const { return qMax(m_ioLimit, m_cpuLimit); }
+    // Cores each CPU slot may use for its own threads when all slots are busy
+    int threadsPerJob() const;
+
+    // Block until a slot is free. Returns false (without a slot) if the
+    // cancel flag is raised while waiting.
+    bool acquireIo(const std::atomic<bool> *cancelFlag);
+    void releaseIo();
+    bool acquireCpu(const std::atomic<bool> *cancelFlag);
+    void releaseCpu();
+
+    // Asks the OS to start reading path ahead of the job that needs it
+    static void adviseWillNeed(const QString &path);
+
+private:
+    static bool acquire(QSemaphore &sem, const std::atomic<bool> *cancelFlag);
+
+    int m_ioLimit;
+    int m_cpuLimit;
+    QSemaphore m_ioSlots;
+    QSemaphore m_cpuSlots;
+};
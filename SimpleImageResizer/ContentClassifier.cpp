@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ContentClassifier.h"
+#include <cmath>
+#include <limits>
+#include <QImage>
+#include <QSet>
+
+static constexpr int SAMPLE_ROWS = 256;            // Rows scanned, spread evenly over the image
+static constexpr int GRAPHIC_MAX_COLOURS = 256;    // Palette-sized images are graphics
+static constexpr double GRAPHIC_MIN_FLAT = 0.6;    // Share of pixels equal to their left neighbour
+
+struct ContentStats {
+    int colours = 0;         // Distinct colours seen, counted up to GRAPHIC_MAX_COLOURS + 1
+    double flat = 0.0;
+    bool translucent = false;
+};
+
+// Row y of img as 32-bit pixels in the wanted layout. Other layouts
+// convert just that row into scratch, never the whole frame.
+static const quint32 *row32(const QImage &img, int y, QImage::Format wanted, QImage &scratch)
+{
+    if (img.format() == wanted)
+        return reinterpret_cast<const quint32 *>(img.constScanLine(y));
+    const QImage line(img.constScanLine(y), img.width(), 1, img.bytesPerLine(), img.format());
+    scratch = line.convertToFormat(wanted);
+    return reinterpret_cast<const quint32 *>(scratch.constScanLine(0));
+}
+
+// Scans every pixel of SAMPLE_ROWS rows. The neighbour and alpha tests are
+// plain loops the compiler vectorises; the colour set stops growing once
+// the image has too many colours to be a graphic.
+static ContentStats measure(const QImage &img)
+{
+    const bool hasAlpha = img.hasAlphaChannel();
+
+    ContentStats stats;
+    QSet<quint32> colours;
+    QImage scratch;
+    qint64 sampled = 0;
+    qint64 flat = 0;
+    const int width = img.width();
+    const int step = qMax(1, img.height() / SAMPLE_ROWS);
+    for (int y = 0; y < img.height(); y += step) {
+        const quint32 *row = row32(img, y, hasAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32,
+                                   scratch);
+        int same = 0;
+        quint32 alpha = 0xff000000u;
+        for (int x = 1; x < width; ++x) {
+            same += (row[x] == row[x - 1]);
+            alpha &= row[x];
+        }
+        alpha &= row[0];
+        flat += same;
+        sampled += width;
+        if (hasAlpha && (alpha & 0xff000000u) != 0xff000000u)
+            stats.translucent = true;
+        for (int x = 0; x < width && colours.size() <= GRAPHIC_MAX_COLOURS; ++x)
+            colours.insert(row[x]);
+    }
+    stats.colours = static_cast<int>(colours.size());
+    stats.flat = sampled > 0 ? double(flat) / sampled : 0.0;
+    return stats;
+}
+
+QList<ProcessingSettings> ContentClassifier::candidates(const QImage &img, const ProcessingSettings &settings)
+{
+    const ContentStats stats = measure(img);
+    ProcessingSettings first = settings;
+    ProcessingSettings second = settings;
+    if (stats.colours <= GRAPHIC_MAX_COLOURS || stats.flat >= GRAPHIC_MIN_FLAT) {
+        first.format = OutputFormat::WebP;
+        first.webpLossless = true;
+        second.format = OutputFormat::PNG;
+    } else if (stats.translucent) {
+        first.format = OutputFormat::AVIF;
+        second.format = OutputFormat::WebP;
+    } else {
+        first.format = OutputFormat::AVIF;
+        second.format = OutputFormat::JPEG;
+    }
+    return { first, second };
+}
+
+double ContentClassifier::psnr(const QImage &reference, const QImage &candidate)
+{
+    if (reference.size() != candidate.size() || reference.isNull()) return 0.0;
+    // Premultiplied, so colour under transparent pixels does not count
+    const QImage::Format wanted = QImage::Format_ARGB32_Premultiplied;
+    QImage refScratch;
+    QImage candScratch;
+    qint64 samples = 0;
+    double squaredError = 0.0;
+    const int width = reference.width();
+    const int step = qMax(1, reference.height() / SAMPLE_ROWS);
+    for (int y = 0; y < reference.height(); y += step) {
+        const auto *a = reinterpret_cast<const uchar *>(row32(reference, y, wanted, refScratch));
+        const auto *b = reinterpret_cast<const uchar *>(row32(candidate, y, wanted, candScratch));
+        qint64 rowError = 0;
+        for (int i = 0; i < width * 4; ++i) {
+            const int d = int(a[i]) - int(b[i]);
+            rowError += d * d;
+        }
+        squaredError += double(rowError);
+        samples += qint64(width) * 4;
+    }
+    if (squaredError <= 0.0) return std::numeric_limits<double>::infinity();
+    return 10.0 * std::log10(255.0 * 255.0 * samples / squaredError);
+}
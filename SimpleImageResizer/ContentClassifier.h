@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QList>
+
+#include "ProcessingJob.h"
+
+class QImage;
+
+// Picks output formats for the Auto setting from what an image looks like.
+// Screenshots and graphics (few colours, long runs of identical pixels) go
+// lossless; photos go to the lossy codecs, keeping alpha where it is used.
+class ContentClassifier {
+public:
+    // The two encodings worth trying for img, most likely winner first:
+    // copies of settings with a concrete format (and WebP lossless for
+    // graphics)
+    static QList<ProcessingSettings> candidates(const QImage &img, const ProcessingSettings &settings);
+    // PSNR in dB of candidate against reference over the rows the classifier
+    // samples; infinite when they match, 0 when the sizes differ
+    static double psnr(const QImage &reference, const QImage &candidate);
+};
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "CostModel.h"
+#include "InputScanner.h"
+#include <cmath>
+#include <QFileInfo>
+
+static constexpr double EWMA_WEIGHT = 0.2;     // Share of each new measurement
+static constexpr double MIN_MEGAPIXELS = 0.05; // Keeps fixed per-file overhead from inflating rates
+static constexpr double ASSUMED_ASPECT = 1.5;  // For fit modes when only the pixel count is known
+static constexpr double TARGET_SIZE_ATTEMPTS = 7.0;
+
+// Rough starting points, replaced by measurements as soon as jobs finish
+static constexpr double DEFAULT_BYTES_PER_PIXEL[] = { 0.35, 1.5, 0.25, 0.12, 1.2, 1.0 };
+static constexpr double DEFAULT_DECODE_RATE[] = { 8000, 15000, 12000, 25000, 60000, 15000 };
+static constexpr double DEFAULT_RESIZE_RATE = 3000;
+static constexpr double DEFAULT_ENCODE_RATE[] = { 6000, 30000, 40000, 150000, 150000 };
+
+static void blend(double &rate, double measured)
+{
+    rate += EWMA_WEIGHT * (measured - rate);
+}
+
+CostModel::CostModel()
+{
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        m_bytesPerPixel[k] = DEFAULT_BYTES_PER_PIXEL[k];
+        m_decodeRate[k] = DEFAULT_DECODE_RATE[k];
+    }
+    m_resizeRate = DEFAULT_RESIZE_RATE;
+    for (int f = 0; f < FORMAT_COUNT; ++f) {
+        m_encodeRate[f * 2] = DEFAULT_ENCODE_RATE[f];
+        m_encodeRate[f * 2 + 1] = DEFAULT_ENCODE_RATE[f] * TARGET_SIZE_ATTEMPTS;
+    }
+}
+
+CostModel::InputKind CostModel::inputKind(const QString &path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "jpg" || suffix == "jpeg") return InputKind::Jpeg;
+    if (suffix == "png") return InputKind::Png;
+    if (suffix == "webp") return InputKind::WebP;
+    if (suffix == "avif") return InputKind::Avif;
+    if (InputScanner::isRawSuffix(suffix)) return InputKind::Raw;
+    return InputKind::Other;
+}
+
+int CostModel::encodeSlot(const ProcessingSettings &settings)
+{
+    // PNG ignores the target size, so it always encodes once
+    bool searched = settings.useTargetSize && settings.format != OutputFormat::PNG;
+    return static_cast<int>(settings.format) * 2 + (searched ? 1 : 0);
+}
+
+double CostModel::outputPixels(double inputPixels, const ProcessingSettings &settings)
+{
+    double width = std::sqrt(inputPixels * ASSUMED_ASPECT);
+    double height = inputPixels / qMax(width, 1.0);
+    switch (settings.resizeMode) {
+    case ResizeMode::Percentage:
+        return inputPixels * settings.resizePercent * settings.resizePercent / 10000.0;
+    case ResizeMode::FitWidth:
+        if (settings.resizeWidth <= 0) break;
+        return inputPixels * std::pow(settings.resizeWidth / width, 2);
+    case ResizeMode::FitHeight:
+        if (settings.resizeHeight <= 0) break;
+        return inputPixels * std::pow(settings.resizeHeight / height, 2);
+    case ResizeMode::FitBoundingBox:
+        if (settings.resizeWidth <= 0 || settings.resizeHeight <= 0) break;
+        return inputPixels * std::pow(qMin(settings.resizeWidth / width, settings.resizeHeight / height), 2);
+    case ResizeMode::NoResize:
+        break;
+    }
+    return inputPixels;
+}
+
+double CostModel::estimate(InputKind kind, qint64 fileSize, qint64 pixels,
+                           const ProcessingSettings &settings) const
+{
+    const int k = static_cast<int>(kind);
+    QMutexLocker lock(&m_mutex);
+    double inPixels = pixels > 0 ? double(pixels) : double(qMax<qint64>(fileSize, 0)) / m_bytesPerPixel[k];
+    double inMp = qMax(inPixels / 1e6, MIN_MEGAPIXELS);
+    double outMp = qMax(outputPixels(inPixels, settings) / 1e6, MIN_MEGAPIXELS);
+    double cost = m_decodeRate[k] * inMp + m_encodeRate[encodeSlot(settings)] * outMp;
+    if (settings.resizeMode != ResizeMode::NoResize)
+        cost += m_resizeRate * inMp;
+    return cost;
+}
+
+void CostModel::record(const ProcessingSettings &settings, const ProcessingResult &result)
+{
+    // Passed-through files were never decoded or encoded, so their zero
+    // timings say nothing about the work real jobs do
+    if (result.status != ResultStatus::Success || result.passedThrough) return;
+    const qint64 inPixels = qint64(result.originalWidth) * result.originalHeight;
+    const qint64 outPixels = qint64(result.newWidth) * result.newHeight;
+    if (inPixels <= 0 || outPixels <= 0) return;
+    const double inMp = qMax(inPixels / 1e6, MIN_MEGAPIXELS);
+    const double outMp = qMax(outPixels / 1e6, MIN_MEGAPIXELS);
+    const int k = static_cast<int>(inputKind(result.inputPath));
+
+    QMutexLocker lock(&m_mutex);
+    blend(m_bytesPerPixel[k], double(result.originalSize) / double(inPixels));
+    blend(m_decodeRate[k], result.decodeUs / inMp);
+    if (settings.resizeMode != ResizeMode::NoResize)
+        blend(m_resizeRate, result.resizeUs / inMp);
+    blend(m_encodeRate[encodeSlot(settings)], result.encodeUs / outMp);
+    m_version.fetch_add(1, std::memory_order_relaxed);
+}
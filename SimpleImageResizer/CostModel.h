@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <QMutex>
+#include <QString>
+
+#include "ProcessingJob.h"
+#include "ProcessingResult.h"
+
+// Estimates how long a job will take from what is known before it starts:
+// file size, dimensions when the input table has probed them, input type
+// and output format / target-size mode. Per-megapixel stage rates start
+// from rough defaults and follow the measured stage times of finished jobs,
+// so the estimates sharpen as the batch runs. Thread-safe.
+class CostModel {
+public:
+    enum class InputKind { Jpeg, Png, WebP, Avif, Raw, Other, Count };
+
+    CostModel();
+
+    static InputKind inputKind(const QString &path);
+
+    // Relative cost in microseconds. pixels <= 0: guessed from fileSize.
+    double estimate(InputKind kind, qint64 fileSize, qint64 pixels, const ProcessingSettings &settings) const;
+
+    // Feeds the stage times of a finished job back into the rates
+    void record(const ProcessingSettings &settings, const ProcessingResult &result);
+
+    // Bumped on every record(), so callers can tell when to re-estimate
+    quint64 version() const { return m_version.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int KIND_COUNT = static_cast<int>(InputKind::Count);
+    static constexpr int FORMAT_COUNT = 5;
+
+    static double outputPixels(double inputPixels, const ProcessingSettings &settings);
+    static int encodeSlot(const ProcessingSettings &settings);
+
+    mutable QMutex m_mutex;
+    double m_bytesPerPixel[KIND_COUNT];
+    double m_decodeRate[KIND_COUNT];            // us per input megapixel
+    double m_resizeRate;                        // us per input megapixel
+    double m_encodeRate[FORMAT_COUNT * 2];      // us per output megapixel, fixed quality / target size
+    std::atomic<quint64> m_version{0};
+};
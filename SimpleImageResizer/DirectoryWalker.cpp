@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "DirectoryWalker.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+static constexpr int FLUSH_INTERVAL_MS = 100;
+
+DirectoryWalker::DirectoryWalker(const QStringList &nameFilters, QObject *parent)
+    : QObject(parent)
+    , m_nameFilters(nameFilters)
+{
+    m_pool = new QThreadPool(this);
+    // Listing is latency-bound rather than CPU-bound, so oversubscribe
+    m_pool->setMaxThreadCount(qBound(4, QThread::idealThreadCount() * 2, 32));
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &DirectoryWalker::flush);
+}
+
+DirectoryWalker::~DirectoryWalker()
+{
+    m_generation.fetch_add(1);
+    m_pool->waitForDone();
+}
+
+void DirectoryWalker::walk(const QString &root)
+{
+    if (!isRunning()) {
+        m_dirsScanned = 0;
+        m_filesFound = 0;
+        m_cancelled = false;
+    }
+    startTask(root, m_generation.load());
+    m_flushTimer->start();
+}
+
+void DirectoryWalker::cancel()
+{
+    if (!isRunning()) return;
+    m_generation.fetch_add(1);
+    m_cancelled = true;
+    QMutexLocker lock(&m_mutex);
+    m_pending.clear();
+}
+
+bool DirectoryWalker::isRunning() const
+{
+    return m_flushTimer->isActive();
+}
+
+void DirectoryWalker::startTask(const QString &dir, int generation)
+{
+    m_activeTasks.fetch_add(1);
+    m_pool->start([this, dir, generation]() {
+        visit(dir, generation);
+        m_activeTasks.fetch_sub(1);
+    });
+}
+
+void DirectoryWalker::visit(const QString &dir, int generation)
+{
+    if (generation != m_generation.load(std::memory_order_relaxed)) return;
+
+    // AllDirs lists directories regardless of the name filters. Symlinked
+    // directories are skipped, as with QDirIterator::Subdirectories.
+    QStringList files;
+    QDirIterator it(dir, m_nameFilters, QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        QString path = it.next();
+        QFileInfo info = it.fileInfo();
+        if (info.isDir()) {
+            if (!info.isSymLink())
+                startTask(path, generation);
+        } else {
+            files << path;
+        }
+        if (generation != m_generation.load(std::memory_order_relaxed)) return;
+    }
+
+    m_dirsScanned.fetch_add(1, std::memory_order_relaxed);
+    if (files.isEmpty()) return;
+    m_filesFound.fetch_add(files.size(), std::memory_order_relaxed);
+    QMutexLocker lock(&m_mutex);
+    if (generation == m_generation.load())
+        m_pending += files;
+}
+
+void DirectoryWalker::flush()
+{
+    // Subdirectory tasks are registered before their parent finishes, so a
+    // zero count means the whole tree has been listed
+    bool idle = (m_activeTasks.load() == 0);
+
+    QStringList batch;
+    {
+        QMutexLocker lock(&m_mutex);
+        batch.swap(m_pending);
+    }
+    if (!batch.isEmpty())
+        emit filesFound(batch);
+    emit progress(m_dirsScanned.load(), m_filesFound.load());
+
+    if (idle) {
+        m_flushTimer->stop();
+        emit finished(m_cancelled);
+    }
+}
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+class QThreadPool;
+class QTimer;
+
+// Recursively collects image files below one or more folders. Every
+// subdirectory is listed by its own pool task, so deep or wide trees on slow
+// storage are walked in parallel. Discovered files are delivered to the GUI
+// thread in batches while the walk continues.
+class DirectoryWalker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DirectoryWalker(const QStringList &nameFilters, QObject *parent = nullptr);
+    ~DirectoryWalker() override;
+
+    // Starts walking root; may be called again while a walk is running
+    void walk(const QString &root);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void filesFound(const QStringList &paths);
+    void progress(int directoriesScanned, int filesFound);
+    void finished(bool cancelled);
+
+private:
+    void startTask(const QString &dir, int generation);
+    void visit(const QString &dir, int generation);
+    void flush();
+
+    QStringList m_nameFilters;
+    QThreadPool *m_pool = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QMutex m_mutex;
+    QStringList m_pending;                 // Guarded by m_mutex
+    std::atomic<int> m_generation{0};      // Bumped on cancel
+    std::atomic<int> m_activeTasks{0};
+    std::atomic<int> m_dirsScanned{0};
+    std::atomic<int> m_filesFound{0};
+    bool m_cancelled = false;
+};
@@ -2,30 +2,274 @@
 // Copyright (C) 2024-2026 thanolion
 
 #include "ImageProcessor.h"
+#include "ConcurrencyLimiter.h"
+#include "AvifCodec.h"
+#include "CancellableDevice.h"
+#include "ContentClassifier.h"
+#include "JpegCodec.h"
+#include "WebpCodec.h"
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <QImage>
 #include <QFile>
 #include <QFileInfo>
-#include <QDir>
 #include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImageReader>
 #include <QImageWriter>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
 #include <libraw/libraw.h>
-#include <avif/avif.h>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static constexpr int RAW_CANCEL_POLL_MS = 20;   // How often running RAW decodes' flags are checked
+static constexpr int RESIZE_ROWS_PER_CHECK = 64; // Output rows between cancel checks while pre-reducing
+static constexpr int SEARCH_ENCODES = 7;         // Probes a target-size search over qualities 1-95 makes
+static constexpr double AUTO_PSNR_TOLERANCE_DB = 0.5; // How much worse than the best an Auto pick may look
+
+static bool isCancelled(const std::atomic<bool> *cancelFlag)
+{
+    return cancelFlag && cancelFlag->load(std::memory_order_relaxed);
+}
 
 static bool isCancelled(const ProcessingJob &job)
 {
-    return job.cancelFlag && job.cancelFlag->load(std::memory_order_relaxed);
+    return isCancelled(job.cancelFlag);
+}
+
+// Holds one of the job's I/O or CPU slots until the end of the scope.
+// Jobs without a limiter always get a slot.
+class LimiterSlot {
+public:
+    enum Kind { Io, Cpu };
+
+    LimiterSlot(const ProcessingJob &job, Kind kind)
+        : m_limiter(job.limiter), m_kind(kind)
+    {
+        if (!m_limiter) {
+            m_acquired = true;
+            return;
+        }
+        m_acquired = (kind == Io) ? m_limiter->acquireIo(job.cancelFlag)
+                                  : m_limiter->acquireCpu(job.cancelFlag);
+    }
+    ~LimiterSlot() { release(); }
+
+    LimiterSlot(const LimiterSlot &) = delete;
+    LimiterSlot &operator=(const LimiterSlot &) = delete;
+
+    bool acquired() const { return m_acquired; }
+
+    void release()
+    {
+        if (!m_acquired) return;
+        m_acquired = false;
+        if (!m_limiter) return;
+        if (m_kind == Io) m_limiter->releaseIo();
+        else              m_limiter->releaseCpu();
+    }
+
+private:
+    ConcurrencyLimiter *m_limiter;
+    Kind m_kind;
+    bool m_acquired = false;
+};
+
+static bool writeOutputFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    qint64 written = file.write(data);
+    file.close();
+    return written == data.size();
 }
 
-static QImage loadRawImage(const QString &path)
+// True if the output would have the input's pixels: the resize leaves its
+// size alone, or it already fits the bounding box
+static bool keepsSize(QSize size, const ProcessingSettings &settings)
 {
-    auto rawOwner = std::make_unique<LibRaw>();
-    LibRaw &raw = *rawOwner;
-#ifdef _WIN32
-    if (raw.open_file(path.toStdWString().c_str()) != LIBRAW_SUCCESS) return {};
+    switch (settings.resizeMode) {
+    case ResizeMode::Percentage:
+        return settings.resizePercent == 100;
+    case ResizeMode::FitWidth:
+        return settings.resizeWidth <= 0 || size.width() == settings.resizeWidth;
+    case ResizeMode::FitHeight:
+        return settings.resizeHeight <= 0 || size.height() == settings.resizeHeight;
+    case ResizeMode::FitBoundingBox:
+        return settings.resizeWidth <= 0 || settings.resizeHeight <= 0
+            || (size.width() <= settings.resizeWidth && size.height() <= settings.resizeHeight);
+    case ResizeMode::NoResize:
+        return true;
+    }
+    return false;
+}
+
+// Size of the input from its header if it is already in the output format;
+// invalid otherwise
+static QSize sizeIfFormat(const QString &path, OutputFormat format, const QByteArray &fmtName)
+{
+    if (format == OutputFormat::AVIF) return AvifCodec::peekSize(path);
+    if (fmtName.isEmpty()) return {};
+    QImageReader reader(path);
+    reader.setDecideFormatFromContent(true);
+    if (reader.format() != fmtName) return {};
+    return reader.size();
+}
+
+// True if an input already in the output format needs no re-encode for
+// its bytes: within the target size, or for JPEG no higher a quality than
+// asked for. Other formats carry no readable quality, so only the target
+// size applies to them.
+static bool meetsRequestedBytes(const QString &path, const ProcessingSettings &settings)
+{
+    if (settings.format == OutputFormat::PNG) return true;
+    if (settings.useTargetSize)
+        return QFileInfo(path).size() <= qint64(settings.targetSizeKB) * 1024;
+    if (settings.format != OutputFormat::JPEG) return true;
+    const int quality = JpegCodec::estimateQuality(path);
+    return quality > 0 && quality <= settings.quality;
+}
+
+// Puts the input at the output path without touching its bytes. QFile::copy
+// clones the file on filesystems that support it (Btrfs, XFS, APFS, ReFS).
+static bool passFileThrough(const QString &from, const QString &to, Passthrough mode)
+{
+    if (QFileInfo(from).canonicalFilePath() == QFileInfo(to).canonicalFilePath()) return true;
+    QFile::remove(to);
+    if (mode == Passthrough::Link) {
+#if defined(Q_OS_WIN)
+        if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                            reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()), nullptr))
+            return true;
 #else
-    if (raw.open_file(path.toUtf8().constData()) != LIBRAW_SUCCESS) return {};
+        if (::link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0)
+            return true;
 #endif
+        // Another volume, or a filesystem without hard links
+    }
+    return QFile::copy(from, to);
+}
+
+// LibRaw stage callback; a nonzero return aborts the decode
+static int rawProgress(void *data, enum LibRaw_progress, int, int)
+{
+    return isCancelled(static_cast<const std::atomic<bool> *>(data)) ? 1 : 0;
+}
+
+// The progress callback only runs between stages, so a long demosaic would
+// still finish. One thread serves every RAW decode in the process: while
+// decodes are registered it checks their jobs' flags and raises LibRaw's
+// own cancel flag, which LibRaw polls inside its unpack and interpolation
+// loops. It sleeps while no decode is running.
+class RawCancelWatcher {
+public:
+    static RawCancelWatcher &instance()
+    {
+        static RawCancelWatcher watcher;
+        return watcher;
+    }
+
+    ~RawCancelWatcher()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_quit = true;
+        }
+        m_changed.wakeAll();
+        if (m_thread) m_thread->wait();
+    }
+
+    RawCancelWatcher(const RawCancelWatcher &) = delete;
+    RawCancelWatcher &operator=(const RawCancelWatcher &) = delete;
+
+    void add(LibRaw *raw, const std::atomic<bool> *cancelFlag)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_thread) {
+            m_thread.reset(QThread::create([this] { run(); }));
+            m_thread->start();
+        }
+        m_decodes.append({ raw, cancelFlag });
+        m_changed.wakeAll();
+    }
+
+    // Once this returns the watcher no longer touches raw
+    void remove(LibRaw *raw)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_decodes.removeIf([raw](const Decode &d) { return d.raw == raw; });
+    }
+
+private:
+    struct Decode {
+        LibRaw *raw;
+        const std::atomic<bool> *cancelFlag;
+    };
+
+    RawCancelWatcher() = default;
+
+    void run()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_quit) {
+            if (m_decodes.isEmpty()) {
+                m_changed.wait(&m_mutex);
+                continue;
+            }
+            for (const Decode &d : std::as_const(m_decodes)) {
+                if (isCancelled(d.cancelFlag)) d.raw->setCancelFlag();
+            }
+            m_changed.wait(&m_mutex, RAW_CANCEL_POLL_MS);
+        }
+    }
+
+    std::unique_ptr<QThread> m_thread;
+    QMutex m_mutex;
+    QWaitCondition m_changed;
+    QList<Decode> m_decodes;
+    bool m_quit = false;
+};
+
+// Registers one decode with the shared watcher for its lifetime
+class RawCancelWatch {
+public:
+    RawCancelWatch(LibRaw &raw, const std::atomic<bool> *cancelFlag)
+        : m_raw(cancelFlag ? &raw : nullptr)
+    {
+        if (m_raw) RawCancelWatcher::instance().add(m_raw, cancelFlag);
+    }
+
+    ~RawCancelWatch()
+    {
+        if (m_raw) RawCancelWatcher::instance().remove(m_raw);
+    }
+
+    RawCancelWatch(const RawCancelWatch &) = delete;
+    RawCancelWatch &operator=(const RawCancelWatch &) = delete;
+
+private:
+    LibRaw *m_raw;
+};
+
+static QImage loadRawImage(const QByteArray &data, const std::atomic<bool> *cancelFlag)
+{
+    auto rawOwner = std::make_unique<LibRaw>();
+    LibRaw &raw = *rawOwner;
+    raw.set_progress_handler(rawProgress, const_cast<std::atomic<bool> *>(cancelFlag));
+    RawCancelWatch watch(raw, cancelFlag);
+    if (raw.open_buffer(data.constData(), static_cast<size_t>(data.size())) != LIBRAW_SUCCESS) return {};
     if (raw.unpack() != LIBRAW_SUCCESS) return {};
     raw.imgdata.params.output_bps = 8;
     raw.imgdata.params.use_auto_wb = 1;
@@ -46,118 +290,426 @@ static QImage loadRawImage(const QString &path)
     return copy;
 }
 
-static QByteArray encodeAvifToMemory(const QImage &img, int quality)
+QImage ImageProcessor::loadImage(const QByteArray &data, const std::atomic<bool> *cancelFlag, int threads)
 {
-    QImage rgbaImg = img.convertToFormat(QImage::Format_RGBA8888);
+    // libjpeg-turbo decodes straight into the image, stopping between row
+    // blocks once cancelled; CMYK and damaged headers fall through to Qt's
+    // reader
+    if (JpegCodec::isJpeg(data)) {
+        QImage jpeg = JpegCodec::decode(data, cancelFlag);
+        if (!jpeg.isNull() || isCancelled(cancelFlag)) return jpeg;
+    }
+    // Qt has no AVIF reader without a plugin, and libavif decodes tiles on
+    // several threads
+    if (AvifCodec::isAvif(data)) {
+        QImage avif = AvifCodec::decode(data, threads);
+        if (!avif.isNull()) return avif;
+    }
+    // Qt's handlers pull from the device in small blocks, so a cancelled
+    // read ends the decode early
+    QBuffer buffer(const_cast<QByteArray *>(&data));
+    buffer.open(QIODevice::ReadOnly);
+    CancellableDevice device(&buffer, cancelFlag);
+    QImage img;
+    QImageReader reader(&device);
+    if (reader.read(&img) || device.cancelled()) return img;
+    return loadRawImage(data, cancelFlag);
+}
 
-    avifImage *avifImg = avifImageCreate(rgbaImg.width(), rgbaImg.height(), 8, AVIF_PIXEL_FORMAT_YUV420);
-    if (!avifImg) return {};
+// Averages each 2x2 block of a 32-bit image. Premultiplied channels average
+// correctly without unpremultiplying. An odd last row or column is paired
+// with itself, so the edge stays where it was rather than being cropped.
+static QImage halveImage(const QImage &src, const std::atomic<bool> *cancelFlag)
+{
+    const int srcWidth = src.width();
+    const int srcHeight = src.height();
+    const int pairs = srcWidth / 2;
+    const int w = (srcWidth + 1) / 2;
+    const int h = (srcHeight + 1) / 2;
+    QImage dst(w, h, src.format());
+    if (dst.isNull()) return {};
+    for (int y = 0; y < h; ++y) {
+        if (y % RESIZE_ROWS_PER_CHECK == 0 && isCancelled(cancelFlag)) return {};
+        const uchar *r0 = src.constScanLine(2 * y);
+        const uchar *r1 = src.constScanLine(qMin(2 * y + 1, srcHeight - 1));
+        uchar *out = dst.scanLine(y);
+        for (int x = 0; x < pairs; ++x) {
+            const uchar *a = r0 + 8 * x;
+            const uchar *b = r1 + 8 * x;
+            for (int c = 0; c < 4; ++c)
+                out[4 * x + c] = static_cast<uchar>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+        }
+        if (pairs < w) {
+            const uchar *a = r0 + 8 * pairs;
+            const uchar *b = r1 + 8 * pairs;
+            for (int c = 0; c < 4; ++c)
+                out[4 * pairs + c] = static_cast<uchar>((a[c] + b[c] + 1) >> 1);
+        }
+    }
+    dst.setColorSpace(src.colorSpace());
+    dst.setDotsPerMeterX(src.dotsPerMeterX());
+    dst.setDotsPerMeterY(src.dotsPerMeterY());
+    return dst;
+}
 
-    avifRGBImage rgb;
-    avifRGBImageSetDefaults(&rgb, avifImg);
-    rgb.format = AVIF_RGB_FORMAT_RGBA;
-    rgb.depth = 8;
-    rgb.pixels = const_cast<uint8_t *>(rgbaImg.constBits());
-    rgb.rowBytes = static_cast<uint32_t>(rgbaImg.bytesPerLine());
+// More than 8 bits per channel, which halving in 32-bit would truncate
+static bool isHighBitDepth(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_BGR30:
+    case QImage::Format_A2BGR30_Premultiplied:
+    case QImage::Format_RGB30:
+    case QImage::Format_A2RGB30_Premultiplied:
+    case QImage::Format_Grayscale16:
+    case QImage::Format_RGBX64:
+    case QImage::Format_RGBA64:
+    case QImage::Format_RGBA64_Premultiplied:
+    case QImage::Format_RGBX16FPx4:
+    case QImage::Format_RGBA16FPx4:
+    case QImage::Format_RGBA16FPx4_Premultiplied:
+    case QImage::Format_RGBX32FPx4:
+    case QImage::Format_RGBA32FPx4:
+    case QImage::Format_RGBA32FPx4_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+}
 
-    if (avifImageRGBToYUV(avifImg, &rgb) != AVIF_RESULT_OK) {
-        avifImageDestroy(avifImg);
-        return {};
+// Smooth scale to exactly target. Large reductions of 8-bit images are
+// first halved with our own box filter, which checks for cancellation every
+// few rows, so the one uninterruptible QImage::scaled() call only sees an
+// image within 2x of the target. High-bit-depth images go straight to
+// scaled(), which keeps their precision.
+static QImage smoothScale(const QImage &img, QSize target, const std::atomic<bool> *cancelFlag)
+{
+    QImage work = img;
+    if (!isHighBitDepth(work.format())
+        && work.width() >= 2 * target.width() && work.height() >= 2 * target.height()) {
+        work = work.convertToFormat(work.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                           : QImage::Format_RGB32);
+        while (work.width() >= 2 * target.width() && work.height() >= 2 * target.height()) {
+            work = halveImage(work, cancelFlag);
+            if (work.isNull()) return {};
+        }
     }
+    if (isCancelled(cancelFlag)) return {};
+    return work.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
 
-    avifEncoder *encoder = avifEncoderCreate();
-    if (!encoder) {
-        avifImageDestroy(avifImg);
-        return {};
+QImage ImageProcessor::resizeImage(const QImage &img, const ProcessingSettings &settings,
+                                   const std::atomic<bool> *cancelFlag)
+{
+    const qint64 w = img.width();
+    const qint64 h = img.height();
+    QSize target;
+    switch (settings.resizeMode) {
+    case ResizeMode::Percentage:
+        target = QSize(static_cast<int>(w * settings.resizePercent / 100),
+                       static_cast<int>(h * settings.resizePercent / 100));
+        break;
+    case ResizeMode::FitWidth:
+        if (settings.resizeWidth <= 0) return img;
+        target = QSize(settings.resizeWidth, qRound(double(h) * settings.resizeWidth / w));
+        break;
+    case ResizeMode::FitHeight:
+        if (settings.resizeHeight <= 0) return img;
+        target = QSize(qRound(double(w) * settings.resizeHeight / h), settings.resizeHeight);
+        break;
+    case ResizeMode::FitBoundingBox:
+        if (settings.resizeWidth <= 0 || settings.resizeHeight <= 0) return img;
+        target = img.size().scaled(settings.resizeWidth, settings.resizeHeight, Qt::KeepAspectRatio);
+        break;
+    case ResizeMode::NoResize:
+        return img;
     }
-    encoder->quality = quality;
-    encoder->qualityAlpha = quality;
-    encoder->speed = 8;
-    encoder->maxThreads = 2;
-    encoder->autoTiling = AVIF_TRUE;
+    return smoothScale(img, target.expandedTo(QSize(1, 1)), cancelFlag);
+}
 
-    avifRWData output = AVIF_DATA_EMPTY;
-    avifResult result = avifEncoderWrite(encoder, avifImg, &output);
-    avifEncoderDestroy(encoder);
-    avifImageDestroy(avifImg);
+// True if every pixel of a 32-bit image with an alpha channel is fully
+// opaque. Each row is AND-reduced in a plain loop the compiler vectorises,
+// and the scan stops at the first row with a translucent pixel.
+static bool isOpaque(const QImage &img, quint32 alphaMask)
+{
+    const int width = img.width();
+    for (int y = 0; y < img.height(); ++y) {
+        const quint32 *row = reinterpret_cast<const quint32 *>(img.constScanLine(y));
+        quint32 all = alphaMask;
+        for (int x = 0; x < width; ++x)
+            all &= row[x];
+        if ((all & alphaMask) != alphaMask) return false;
+    }
+    return true;
+}
 
-    QByteArray bytes;
-    if (result == AVIF_RESULT_OK) {
-        bytes = QByteArray(reinterpret_cast<const char *>(output.data), output.size);
+// Returns img as its opaque layout when it has an alpha channel that is
+// fully opaque, so encoders write RGB and AVIF skips its alpha plane. The
+// result shares img's pixels instead of copying them.
+static QImage withoutOpaqueAlpha(const QImage &img)
+{
+    QImage::Format opaqueFormat;
+    quint32 alphaMask;
+    switch (img.format()) {
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        opaqueFormat = QImage::Format_RGB32;
+        alphaMask = 0xff000000u;
+        break;
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        opaqueFormat = QImage::Format_RGBX8888;
+        // Alpha is the fourth byte in memory
+        alphaMask = (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) ? 0xff000000u : 0x000000ffu;
+        break;
+    default:
+        return img;
     }
-    avifRWDataFree(&output);
-    return bytes;
+    if (!isOpaque(img, alphaMask)) return img;
+
+    QImage opaque(img.constBits(), img.width(), img.height(), img.bytesPerLine(), opaqueFormat);
+    opaque.setColorSpace(img.colorSpace());
+    opaque.setDotsPerMeterX(img.dotsPerMeterX());
+    opaque.setDotsPerMeterY(img.dotsPerMeterY());
+    return opaque;
 }
 
-QImage ImageProcessor::loadAvifImage(const QString &path)
+// Encodes once at a fixed quality into data. Streaming encoders stop with
+// KeptOriginal as soon as the output grows past maxBytes (if > 0).
+static ResultStatus encodeAtQuality(const QImage &img, const ProcessingSettings &settings,
+                                    const QByteArray &fmtName, int quality,
+                                    const std::atomic<bool> *cancelFlag,
+                                    QByteArray &data, QString &errorMessage, qint64 maxBytes = 0)
 {
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) return {};
-    QByteArray data = file.readAll();
-
-    avifImage *avifImg = avifImageCreateEmpty();
-    if (!avifImg) return {};
-    avifDecoder *decoder = avifDecoderCreate();
-    if (!decoder) {
-        avifImageDestroy(avifImg);
-        return {};
+    const OutputFormat format = settings.format;
+    if (format == OutputFormat::JPEG)
+        return JpegCodec::encode(img, settings, quality, cancelFlag, data, errorMessage, maxBytes);
+    if (format == OutputFormat::WebP)
+        return WebpCodec::encode(img, settings, quality, 0, cancelFlag, data, errorMessage, maxBytes);
+    // libavif/libaom has no abort hook, so AVIF is only checked between
+    // attempts; libwebp and JpegCodec poll the flag themselves. Qt's
+    // PNG writer flushes through the device as it compresses and stops at
+    // the first failed write.
+    data.clear();
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    CancellableDevice device(&buffer, cancelFlag, maxBytes);
+    QImageWriter writer(&device, fmtName);
+    if (format != OutputFormat::PNG)
+        writer.setQuality(quality);
+    if (!writer.write(img)) {
+        if (device.overLimit()) return ResultStatus::KeptOriginal;
+        errorMessage = "Failed to encode image: " + writer.errorString();
+        return ResultStatus::FailedToSave;
     }
-    avifResult result = avifDecoderReadMemory(decoder, avifImg,
-        reinterpret_cast<const uint8_t *>(data.constData()), data.size());
-
-    QImage qImg;
-    if (result == AVIF_RESULT_OK) {
-        avifRGBImage rgb;
-        avifRGBImageSetDefaults(&rgb, avifImg);
-        rgb.format = AVIF_RGB_FORMAT_RGBA;
-        rgb.depth = 8;
-        if (avifRGBImageAllocatePixels(&rgb) != AVIF_RESULT_OK) {
-            avifDecoderDestroy(decoder);
-            avifImageDestroy(avifImg);
-            return {};
+    return ResultStatus::Success;
+}
+
+ResultStatus ImageProcessor::encode(const QImage &source, const ProcessingSettings &settings,
+                                    const std::atomic<bool> *cancelFlag,
+                                    QByteArray &data, QString &errorMessage, qint64 maxBytes,
+                                    ProcessingResult *info)
+{
+    if (settings.format == OutputFormat::Auto)
+        return encodeAuto(source, settings, cancelFlag, data, errorMessage, maxBytes, info);
+    if (info) info->format = settings.format;
+
+    QByteArray fmtName = formatName(settings.format);
+    // JPEG has no alpha to drop. The opaque view is valid only while source
+    // is, which outlives every encode below.
+    const QImage img = (settings.format == OutputFormat::JPEG) ? source : withoutOpaqueAlpha(source);
+
+    // libwebp's own rate control usually replaces the quality search; only
+    // content it cannot bring under the target falls through to the search.
+    // Lossless WebP has no size to aim for.
+    const bool webpTarget = settings.useTargetSize && !settings.webpLossless;
+    if (settings.format == OutputFormat::WebP) {
+        qint64 targetBytes = webpTarget ? settings.targetSizeKB * 1024 : 0;
+        ResultStatus status = WebpCodec::encode(img, settings, settings.quality, targetBytes, cancelFlag,
+                                                data, errorMessage, maxBytes);
+        if (status != ResultStatus::Success || targetBytes <= 0 || data.size() <= targetBytes) {
+            if (status == ResultStatus::Success && maxBytes > 0 && data.size() > maxBytes)
+                return ResultStatus::KeptOriginal;
+            return status;
         }
-        if (avifImageYUVToRGB(avifImg, &rgb) == AVIF_RESULT_OK) {
-            QImage temp(rgb.pixels, rgb.width, rgb.height,
-                       rgb.rowBytes, QImage::Format_RGBA8888);
-            qImg = temp.copy(); // deep copy before freeing
+    }
+
+    const bool search = settings.useTargetSize && settings.format != OutputFormat::PNG;
+
+    // AVIF encodes share one RGB to YUV conversion, and with a time budget
+    // the speed is chosen for all the encodes the search is expected to make
+    std::unique_ptr<AvifCodec::Encoder> avifEncoder;
+    if (settings.format == OutputFormat::AVIF) {
+        avifEncoder = std::make_unique<AvifCodec::Encoder>(img, settings, search ? SEARCH_ENCODES : 1);
+        if (info) info->avifSpeed = avifEncoder->speed();
+    }
+
+    if (!search) {
+        ResultStatus status = ResultStatus::FailedToSave;
+        if (!avifEncoder)
+            status = encodeAtQuality(img, settings, fmtName, settings.quality, cancelFlag, data,
+                                     errorMessage, maxBytes);
+        else if (avifEncoder->encode(settings.quality, data, errorMessage))
+            status = ResultStatus::Success;
+        if (status == ResultStatus::FailedToSave && isCancelled(cancelFlag))
+            return ResultStatus::Cancelled;
+        // AVIF is only measured once complete
+        if (status == ResultStatus::Success && maxBytes > 0 && data.size() > maxBytes)
+            return ResultStatus::KeptOriginal;
+        return status;
+    }
+
+    // Binary search for quality to hit target file size
+    qint64 targetBytes = settings.targetSizeKB * 1024;
+    int lo = 1, hi = 95;
+    QByteArray bestData;
+
+    // JPEG probes share one colour conversion and DCT pass
+    std::unique_ptr<JpegCodec::QualityProbe> jpegProbe;
+    if (settings.format == OutputFormat::JPEG) {
+        jpegProbe = std::make_unique<JpegCodec::QualityProbe>(img, settings, cancelFlag);
+        if (!jpegProbe->isValid()) jpegProbe.reset();
+    }
+    auto encodeProbe = [&](int quality, QByteArray &probe) {
+        if (jpegProbe) return jpegProbe->encode(quality, probe, errorMessage);
+        if (avifEncoder) return avifEncoder->encode(quality, probe, errorMessage);
+        return encodeAtQuality(img, settings, fmtName, quality, cancelFlag, probe, errorMessage)
+            == ResultStatus::Success;
+    };
+
+    for (int iter = 0; iter < 10 && lo <= hi; ++iter) {
+        // Checkpoint 3: inside binary-search loop
+        if (isCancelled(cancelFlag))
+            return ResultStatus::Cancelled;
+        int mid = (lo + hi) / 2;
+        QByteArray probe;
+        if (!encodeProbe(mid, probe))
+            return isCancelled(cancelFlag) ? ResultStatus::Cancelled : ResultStatus::FailedToSave;
+
+        if (probe.size() <= targetBytes) {
+            bestData = probe;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
         }
-        avifRGBImageFreePixels(&rgb);
     }
 
-    avifDecoderDestroy(decoder);
-    avifImageDestroy(avifImg);
-    return qImg;
+    // If we never got under target, use lowest quality result
+    if (bestData.isEmpty()) {
+        if (!encodeProbe(1, bestData)) {
+            if (isCancelled(cancelFlag)) return ResultStatus::Cancelled;
+            errorMessage = "Failed to encode image at minimum quality";
+            return ResultStatus::FailedToSave;
+        }
+    }
+    data = bestData;
+    if (maxBytes > 0 && data.size() > maxBytes)
+        return ResultStatus::KeptOriginal;
+    return ResultStatus::Success;
 }
 
-bool ImageProcessor::saveAvifImage(const QImage &img, const QString &path, int quality)
+ResultStatus ImageProcessor::encodeAuto(const QImage &img, const ProcessingSettings &settings,
+                                        const std::atomic<bool> *cancelFlag, QByteArray &data,
+                                        QString &errorMessage, qint64 maxBytes, ProcessingResult *info)
 {
-    QByteArray data = encodeAvifToMemory(img, quality);
-    if (data.isEmpty()) return false;
+    struct Attempt {
+        ProcessingSettings settings;
+        ResultStatus status = ResultStatus::FailedToSave;
+        QByteArray data;
+        QString error;
+        ProcessingResult info;
+        double psnr = std::numeric_limits<double>::infinity();
+    };
+    QList<Attempt> attempts;
+    for (const ProcessingSettings &candidate : ContentClassifier::candidates(img, settings))
+        attempts.append(Attempt{candidate});
+    const auto lossless = [](const Attempt &a) {
+        return a.settings.format == OutputFormat::PNG || a.settings.webpLossless;
+    };
+    const qint64 targetBytes = settings.targetSizeKB * 1024;
+    const auto fits = [&](const Attempt &a) { return a.data.size() <= targetBytes; };
+
+    // One after the other on this thread, inside the job's CPU slot and
+    // with the thread's encoder handles and scratch buffers
+    int succeeded = 0;
+    bool anyFits = false;
+    for (Attempt &a : attempts) {
+        if (isCancelled(cancelFlag)) return ResultStatus::Cancelled;
+        a.status = encode(img, a.settings, cancelFlag, a.data, a.error, maxBytes, &a.info);
+        if (a.status != ResultStatus::Success) continue;
+        ++succeeded;
+        anyFits = anyFits || fits(a);
+    }
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) return false;
-    qint64 written = file.write(data);
-    file.close();
-    return written == data.size();
-}
+    // Graphics only get lossless candidates, which cannot aim at a size;
+    // when neither fits the target, lossy WebP searches for it
+    if (settings.useTargetSize && !anyFits && std::all_of(attempts.cbegin(), attempts.cend(), lossless)) {
+        if (isCancelled(cancelFlag)) return ResultStatus::Cancelled;
+        Attempt lossy{settings};
+        lossy.settings.format = OutputFormat::WebP;
+        lossy.settings.webpLossless = false;
+        lossy.status = encode(img, lossy.settings, cancelFlag, lossy.data, lossy.error, maxBytes, &lossy.info);
+        if (lossy.status == ResultStatus::Success) ++succeeded;
+        attempts.append(std::move(lossy));
+    }
 
-QImage ImageProcessor::loadImage(const QString &path)
-{
-    QImage img(path);
-    if (!img.isNull()) return img;
-    // Try AVIF (since Qt doesn't natively support it without plugin)
-    img = loadAvifImage(path);
-    if (!img.isNull()) return img;
-    return loadRawImage(path);
+    // The formats' quality scales do not match, so bytes alone would favour
+    // whichever codec reads the number more loosely. Lossy results are
+    // decoded and measured against the image; lossless ones are exact.
+    if (succeeded > 1) {
+        for (Attempt &a : attempts) {
+            if (a.status != ResultStatus::Success || lossless(a))
+                continue;
+            a.psnr = ContentClassifier::psnr(img, loadImage(a.data, cancelFlag));
+            if (isCancelled(cancelFlag)) return ResultStatus::Cancelled;
+        }
+    }
+    double bestPsnr = -1.0;
+    for (const Attempt &a : attempts) {
+        if (a.status == ResultStatus::Success) bestPsnr = qMax(bestPsnr, a.psnr);
+    }
+    // With a target size, results that fit it win, the better-looking first
+    // (or the smallest if none fits); otherwise the smallest that looks
+    // about as good as the best
+    const Attempt *best = nullptr;
+    for (const Attempt &a : attempts) {
+        if (a.status != ResultStatus::Success) continue;
+        bool better;
+        if (!settings.useTargetSize)
+            better = a.psnr >= bestPsnr - AUTO_PSNR_TOLERANCE_DB && (!best || a.data.size() < best->data.size());
+        else if (!best)
+            better = true;
+        else if (fits(a) != fits(*best))
+            better = fits(a);
+        else
+            better = fits(a) ? a.psnr > best->psnr : a.data.size() < best->data.size();
+        if (better) best = &a;
+    }
+    if (!best) {
+        // Cancelled beats everything else, then KeptOriginal if every candidate was too large
+        ResultStatus status = ResultStatus::KeptOriginal;
+        for (const Attempt &a : attempts) {
+            if (a.status == ResultStatus::Cancelled) return ResultStatus::Cancelled;
+            if (a.status == ResultStatus::FailedToSave) {
+                status = ResultStatus::FailedToSave;
+                errorMessage = a.error;
+            }
+        }
+        return status;
+    }
+    data = best->data;
+    if (info) {
+        info->format = best->info.format;
+        info->avifSpeed = best->info.avifSpeed;
+    }
+    return ResultStatus::Success;
 }
 
 ProcessingResult ImageProcessor::process(const ProcessingJob &job)
 {
+    const ProcessingSettings &settings = *job.settings;
     ProcessingResult result;
     result.inputPath = job.inputPath;
-
-    QFileInfo inputInfo(job.inputPath);
-    result.originalSize = inputInfo.size();
+    result.index = job.index;
 
     // Checkpoint 1: before image load
     if (isCancelled(job)) {
@@ -165,7 +717,65 @@ ProcessingResult ImageProcessor::process(const ProcessingJob &job)
         return result;
     }
 
-    QImage img = loadImage(job.inputPath);
+    // Inputs already in the output format and size need no decode or
+    // encode, unless they are over the target size or a higher quality than
+    // asked for. The probes read the disk, so they count as I/O.
+    if (settings.passthrough != Passthrough::Off) {
+        LimiterSlot ioSlot(job, LimiterSlot::Io);
+        if (!ioSlot.acquired()) {
+            result.status = ResultStatus::Cancelled;
+            return result;
+        }
+        const QSize size = sizeIfFormat(job.inputPath, settings.format, formatName(settings.format));
+        if (size.isValid() && keepsSize(size, settings)
+            && meetsRequestedBytes(job.inputPath, settings)) {
+            result.outputPath = job.outputPath;
+            if (!passFileThrough(job.inputPath, job.outputPath, settings.passthrough)) {
+                result.status = ResultStatus::FailedToSave;
+                result.errorMessage = "Cannot copy to output file: " + job.outputPath;
+                return result;
+            }
+            result.originalSize = result.newSize = QFileInfo(job.inputPath).size();
+            result.originalWidth = result.newWidth = size.width();
+            result.originalHeight = result.newHeight = size.height();
+            result.passedThrough = true;
+            result.format = settings.format;
+            result.errorMessage = "unchanged, copied as is";
+            return result;
+        }
+    }
+
+    // I/O stage: pull the whole input into memory so decoding never waits on storage
+    QByteArray inputData;
+    {
+        LimiterSlot ioSlot(job, LimiterSlot::Io);
+        if (!ioSlot.acquired()) {
+            result.status = ResultStatus::Cancelled;
+            return result;
+        }
+        QFile inFile(job.inputPath);
+        if (inFile.open(QIODevice::ReadOnly))
+            inputData = inFile.readAll();
+    }
+    result.originalSize = inputData.size();
+
+    // CPU stage: decode, resize and encode into memory
+    LimiterSlot cpuSlot(job, LimiterSlot::Cpu);
+    if (!cpuSlot.acquired()) {
+        result.status = ResultStatus::Cancelled;
+        return result;
+    }
+
+    QElapsedTimer stageClock;
+    stageClock.start();
+    QImage img = loadImage(inputData, job.cancelFlag, job.decodeThreads);
+    result.decodeUs = stageClock.nsecsElapsed() / 1000;
+    inputData = QByteArray();  // Release the compressed input before encoding
+    // A cancelled decode may have returned a partial image or none at all
+    if (isCancelled(job)) {
+        result.status = ResultStatus::Cancelled;
+        return result;
+    }
     if (img.isNull()) {
         result.status = ResultStatus::FailedToLoad;
         result.errorMessage = "Failed to load image: " + job.inputPath;
@@ -175,47 +785,10 @@ ProcessingResult ImageProcessor::process(const ProcessingJob &job)
     result.originalWidth = img.width();
     result.originalHeight = img.height();
 
-    // Resize
-    QImage resized;
-    switch (job.resizeMode) {
-    case ResizeMode::Percentage: {
-        int newW = static_cast<int>(static_cast<qint64>(img.width()) * job.resizePercent / 100);
-        int newH = static_cast<int>(static_cast<qint64>(img.height()) * job.resizePercent / 100);
-        if (newW < 1) newW = 1;
-        if (newH < 1) newH = 1;
-        resized = img.scaled(newW, newH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        break;
-    }
-    case ResizeMode::FitWidth:
-        if (job.resizeWidth > 0) {
-            resized = img.scaledToWidth(job.resizeWidth, Qt::SmoothTransformation);
-        } else {
-            resized = img;
-        }
-        break;
-    case ResizeMode::FitHeight:
-        if (job.resizeHeight > 0) {
-            resized = img.scaledToHeight(job.resizeHeight, Qt::SmoothTransformation);
-        } else {
-            resized = img;
-        }
-        break;
-    case ResizeMode::FitBoundingBox:
-        if (job.resizeWidth > 0 && job.resizeHeight > 0) {
-            resized = img.scaled(job.resizeWidth, job.resizeHeight,
-                                 Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        } else {
-            resized = img;
-        }
-        break;
-    case ResizeMode::NoResize:
-        resized = img;
-        break;
-    default:
-        result.status = ResultStatus::FailedToSave;
-        result.errorMessage = "Unknown resize mode";
-        return result;
-    }
+    stageClock.restart();
+    QImage resized = resizeImage(img, settings, job.cancelFlag);
+    img = QImage();
+    result.resizeUs = stageClock.nsecsElapsed() / 1000;
 
     result.newWidth = resized.width();
     result.newHeight = resized.height();
@@ -226,120 +799,72 @@ ProcessingResult ImageProcessor::process(const ProcessingJob &job)
         return result;
     }
 
-    QByteArray fmtName = formatName(job.format);
     QString outputPath = job.outputPath;
     result.outputPath = outputPath;
 
-    if (job.useTargetSize && job.format == OutputFormat::PNG) {
-        result.errorMessage = "Target size not supported for PNG format";
-    }
-
-    if (job.useTargetSize && job.format != OutputFormat::PNG) {
-        // Binary search for quality to hit target file size
-        qint64 targetBytes = job.targetSizeKB * 1024;
-        int lo = 1, hi = 95;
-        int bestQuality = lo;
-        QByteArray bestData;
-
-        for (int iter = 0; iter < 10 && lo <= hi; ++iter) {
-            // Checkpoint 3: inside binary-search loop
-            if (isCancelled(job)) {
-                result.status = ResultStatus::Cancelled;
-                return result;
-            }
-            int mid = (lo + hi) / 2;
-            QByteArray data;
-            if (job.format == OutputFormat::AVIF) {
-                data = encodeAvifToMemory(resized, mid);
-                if (data.isEmpty()) {
-                    result.status = ResultStatus::FailedToSave;
-                    result.errorMessage = "Failed to encode AVIF at quality " + QString::number(mid);
-                    return result;
-                }
-            } else {
-                QBuffer buffer(&data);
-                buffer.open(QIODevice::WriteOnly);
-                QImageWriter writer(&buffer, fmtName);
-                writer.setQuality(mid);
-                if (!writer.write(resized)) {
-                    result.status = ResultStatus::FailedToSave;
-                    result.errorMessage = "Failed to encode image at quality " + QString::number(mid);
-                    return result;
-                }
-                buffer.close();
-            }
-
-            if (data.size() <= targetBytes) {
-                bestQuality = mid;
-                bestData = data;
-                lo = mid + 1;
-            } else {
-                hi = mid - 1;
-            }
-        }
-
-        // If we never got under target, use lowest quality result
-        if (bestData.isEmpty()) {
-            if (job.format == OutputFormat::AVIF) {
-                bestData = encodeAvifToMemory(resized, 1);
-                if (bestData.isEmpty()) {
-                    result.status = ResultStatus::FailedToSave;
-                    result.errorMessage = "Failed to encode AVIF at minimum quality";
-                    return result;
-                }
-            } else {
-                QBuffer buffer(&bestData);
-                buffer.open(QIODevice::WriteOnly);
-                QImageWriter writer(&buffer, fmtName);
-                writer.setQuality(1);
-                if (!writer.write(resized)) {
-                    result.status = ResultStatus::FailedToSave;
-                    result.errorMessage = "Failed to encode image at minimum quality";
-                    return result;
-                }
-                buffer.close();
-            }
-        }
-
-        // Checkpoint 4: before final file write
-        if (isCancelled(job)) {
+    QByteArray outputData;
+    QString encodeError;
+    stageClock.restart();
+    const qint64 maxBytes = settings.neverLarger ? result.originalSize : 0;
+    ResultStatus encodeStatus = encode(resized, settings, job.cancelFlag, outputData, encodeError,
+                                       maxBytes, &result);
+    result.encodeUs = stageClock.nsecsElapsed() / 1000;
+    if (encodeStatus == ResultStatus::KeptOriginal) {
+        cpuSlot.release();
+        LimiterSlot ioSlot(job, LimiterSlot::Io);
+        if (!ioSlot.acquired()) {
             result.status = ResultStatus::Cancelled;
             return result;
         }
-
-        QFile outFile(outputPath);
-        if (!outFile.open(QIODevice::WriteOnly)) {
-            result.status = ResultStatus::FailedToSave;
-            result.errorMessage = "Cannot open output file: " + outputPath;
-            return result;
-        }
-        outFile.write(bestData);
-        outFile.close();
-        result.newSize = bestData.size();
-    } else {
-        // Normal save (no target size)
-        if (job.format == OutputFormat::AVIF) {
-            if (!saveAvifImage(resized, outputPath, job.quality)) {
+        // An original in the output format is copied to the output path;
+        // any other stays where it is as the result
+        if (sizeIfFormat(job.inputPath, settings.format, formatName(settings.format)).isValid()) {
+            if (!passFileThrough(job.inputPath, outputPath, Passthrough::Copy)) {
                 result.status = ResultStatus::FailedToSave;
-                result.errorMessage = "Failed to save AVIF: " + outputPath;
+                result.errorMessage = "Cannot copy to output file: " + outputPath;
                 return result;
             }
-            QFileInfo outInfo(outputPath);
-            result.newSize = outInfo.size();
         } else {
-            QImageWriter writer(outputPath, fmtName);
-            if (job.format != OutputFormat::PNG) {
-                writer.setQuality(job.quality);
-            }
-            if (!writer.write(resized)) {
-                result.status = ResultStatus::FailedToSave;
-                result.errorMessage = "Failed to save: " + writer.errorString();
-                return result;
-            }
-            QFileInfo outInfo(outputPath);
-            result.newSize = outInfo.size();
+            result.outputPath = job.inputPath;
         }
+        result.status = ResultStatus::KeptOriginal;
+        result.newSize = result.originalSize;
+        result.newWidth = result.originalWidth;
+        result.newHeight = result.originalHeight;
+        return result;
+    }
+    if (encodeStatus != ResultStatus::Success) {
+        result.status = encodeStatus;
+        result.errorMessage = encodeError;
+        return result;
     }
+    if (settings.format == OutputFormat::Auto) {
+        // The planner left the extension for the chosen format to be added here
+        outputPath += formatExtension(result.format);
+        result.outputPath = outputPath;
+    } else if (settings.useTargetSize && settings.format == OutputFormat::PNG) {
+        result.errorMessage = "Target size not supported for PNG format";
+    }
+    cpuSlot.release();
+
+    // Checkpoint 4: before final file write
+    if (isCancelled(job)) {
+        result.status = ResultStatus::Cancelled;
+        return result;
+    }
+
+    // I/O stage: write the encoded bytes
+    LimiterSlot ioSlot(job, LimiterSlot::Io);
+    if (!ioSlot.acquired()) {
+        result.status = ResultStatus::Cancelled;
+        return result;
+    }
+    if (!writeOutputFile(outputPath, outputData)) {
+        result.status = ResultStatus::FailedToSave;
+        result.errorMessage = "Cannot write output file: " + outputPath;
+        return result;
+    }
+    result.newSize = outputData.size();
 
     result.status = ResultStatus::Success;
     return result;
@@ -352,10 +877,18 @@ QString ImageProcessor::formatExtension(OutputFormat fmt)
     case OutputFormat::PNG:  return ".png";
     case OutputFormat::WebP: return ".webp";
     case OutputFormat::AVIF: return ".avif";
+    case OutputFormat::Auto: return {};  // Appended once the image's format is chosen
     }
     return ".jpg";
 }
 
+QStringList ImageProcessor::possibleExtensions(OutputFormat fmt)
+{
+    if (fmt != OutputFormat::Auto) return {formatExtension(fmt)};
+    return {formatExtension(OutputFormat::JPEG), formatExtension(OutputFormat::PNG),
+            formatExtension(OutputFormat::WebP), formatExtension(OutputFormat::AVIF)};
+}
+
 QByteArray ImageProcessor::formatName(OutputFormat fmt)
 {
     switch (fmt) {
@@ -363,32 +896,7 @@ QByteArray ImageProcessor::formatName(OutputFormat fmt)
     case OutputFormat::PNG:  return "png";
     case OutputFormat::WebP: return "webp";
     case OutputFormat::AVIF: return "avif";
+    case OutputFormat::Auto: return {};
     }
     return "jpeg";
 }
-
-QString ImageProcessor::buildOutputPath(const QString &inputPath, const QString &outputDir, const QString &ext)
-{
-    QFileInfo info(inputPath);
-    QString baseName = info.completeBaseName();
-    QString outPath = QDir(outputDir).filePath(baseName + ext);
-
-    // If output would overwrite input, append _resized
-    if (QFileInfo(outPath) == QFileInfo(inputPath)) {
-        outPath = QDir(outputDir).filePath(baseName + "_resized" + ext);
-    }
-
-    // Avoid overwriting existing output files
-    if (QFile::exists(outPath)) {
-        int counter = 1;
-        QString candidate;
-        do {
-            candidate = QDir(outputDir).filePath(baseName + QString("_%1").arg(counter) + ext);
-            ++counter;
-            if (counter > 10000) return outPath; // Safety limit
-        } while (QFile::exists(candidate));
-        outPath = candidate;
-    }
-
-    return outPath;
-}
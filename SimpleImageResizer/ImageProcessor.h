@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <QStringList>
+
 #include "ProcessingJob.h"
 #include "ProcessingResult.h"
 
@@ -11,12 +13,38 @@ class QImage;
 class ImageProcessor {
 public:
     static ProcessingResult process(const ProcessingJob &job);
-    static QString buildOutputPath(const QString &inputPath, const QString &outputDir, const QString &ext);
     static QString formatExtension(OutputFormat fmt);
+    // Every extension an output in fmt may end up with
+    static QStringList possibleExtensions(OutputFormat fmt);
+    // Decodes any supported input (JPEG, Qt formats, AVIF, camera RAW). Qt
+    // and RAW decodes stop early once cancelFlag is raised; callers must
+    // check it before trusting the result. threads bounds the decoders that
+    // can split their work (AVIF).
+    static QImage loadImage(const QByteArray &data, const std::atomic<bool> *cancelFlag = nullptr,
+                            int threads = 1);
+    // Returns a null image if cancelFlag is raised part-way through
+    static QImage resizeImage(const QImage &img, const ProcessingSettings &settings,
+                              const std::atomic<bool> *cancelFlag = nullptr);
+    // Encodes img in memory with the format, quality or target size from
+    // settings. Returns Cancelled if cancelFlag is raised while encoding;
+    // PNG, WebP and JPEG stop mid-stream, AVIF between attempts.
+    // Returns KeptOriginal if the output would be larger than maxBytes (if
+    // > 0); PNG, WebP and JPEG stop as soon as they pass it. info, if given,
+    // receives the format the output was encoded in and the libaom speed of
+    // an AVIF. Images whose alpha channel is fully opaque are encoded
+    // without it.
+    static ResultStatus encode(const QImage &img, const ProcessingSettings &settings,
+                               const std::atomic<bool> *cancelFlag,
+                               QByteArray &data, QString &errorMessage, qint64 maxBytes = 0,
+                               ProcessingResult *info = nullptr);
 
 private:
-    static QImage loadImage(const QString &path);
     static QByteArray formatName(OutputFormat fmt);
-    static QImage loadAvifImage(const QString &path);
-    static bool saveAvifImage(const QImage &img, const QString &path, int quality);
+    // Encodes the classifier's two candidates in turn and keeps the smaller
+    // of those that look as good as the best of them. With a target size it
+    // keeps the best-looking result that fits, adding lossy WebP when only
+    // lossless candidates were tried and neither fits.
+    static ResultStatus encodeAuto(const QImage &img, const ProcessingSettings &settings,
+                                   const std::atomic<bool> *cancelFlag, QByteArray &data,
+                                   QString &errorMessage, qint64 maxBytes, ProcessingResult *info);
 };
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "InputFileModel.h"
+#include "ThumbnailCache.h"
+#include <algorithm>
+#include <functional>
+
+InputFileModel::InputFileModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void InputFileModel::setThumbnailCache(ThumbnailCache *thumbnails)
+{
+    m_thumbnails = thumbnails;
+    connect(thumbnails, &ThumbnailCache::thumbnailsReady, this, [this]() {
+        // Views only repaint the rows they show, so one signal covers every row
+        if (!m_files.isEmpty())
+            emit dataChanged(index(0, NameColumn), index(static_cast<int>(m_files.size()) - 1, NameColumn),
+                             {Qt::DecorationRole});
+    });
+}
+
+int InputFileModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_files.size());
+}
+
+int InputFileModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QString InputFileModel::formatSize(qint64 bytes)
+{
+    if (bytes >= 1024 * 1024)
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 2) + " MB";
+    return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+}
+
+QString InputFileModel::fileName(const QString &path)
+{
+    // Paths come from Qt APIs and always use '/'; avoids a QFileInfo per cell
+    return path.mid(path.lastIndexOf('/') + 1);
+}
+
+QVariant InputFileModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_files.size()) return {};
+    const InputFileInfo &file = m_files.at(index.row());
+
+    if (role == Qt::UserRole) return file.path;
+    if (role == Qt::ToolTipRole && index.column() == NameColumn) return file.path;
+    if (role == Qt::DecorationRole && index.column() == NameColumn && m_thumbnails) {
+        QPixmap thumbnail = m_thumbnails->thumbnail(file.path);
+        if (!thumbnail.isNull()) return thumbnail;
+        return {};
+    }
+    if (role != Qt::DisplayRole) return {};
+
+    switch (index.column()) {
+    case NameColumn:
+        return fileName(file.path);
+    case SizeColumn:
+        return formatSize(file.size);
+    case DimensionsColumn:
+        if (file.width > 0 && file.height > 0)
+            return QString("%1 x %2").arg(file.width).arg(file.height);
+        return QString("?");
+    }
+    return {};
+}
+
+QVariant InputFileModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return {};
+    if (orientation == Qt::Vertical) return section + 1;
+    switch (section) {
+    case NameColumn:       return QString("File Name");
+    case SizeColumn:       return QString("Size");
+    case DimensionsColumn: return QString("Dimensions");
+    }
+    return {};
+}
+
+void InputFileModel::appendFiles(const QList<InputFileInfo> &files)
+{
+    if (files.isEmpty()) return;
+    int first = static_cast<int>(m_files.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(files.size()) - 1);
+    m_files += files;
+    endInsertRows();
+}
+
+void InputFileModel::removeRowList(QList<int> rows)
+{
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // Walk from the bottom, merging adjacent rows into one removal each
+    qsizetype i = 0;
+    while (i < rows.size()) {
+        int last = rows.at(i);
+        int first = last;
+        while (i + 1 < rows.size() && rows.at(i + 1) == first - 1) {
+            ++i;
+            first = rows.at(i);
+        }
+        ++i;
+        if (first < 0 || last >= m_files.size()) continue;
+        beginRemoveRows(QModelIndex(), first, last);
+        m_files.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+}
+
+void InputFileModel::clear()
+{
+    beginResetModel();
+    m_files.clear();
+    m_files.squeeze();
+    endResetModel();
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QList>
+
+#include "InputScanner.h"
+
+class ThumbnailCache;
+
+// Input files backing the input table. Rows are stored compactly and cell
+// text is formatted on demand, so only visible rows cost anything; the same
+// goes for thumbnails, which are requested when a view asks for a row's
+// decoration.
+class InputFileModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column { NameColumn, SizeColumn, DimensionsColumn, ColumnCount };
+
+    explicit InputFileModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void setThumbnailCache(ThumbnailCache *thumbnails);
+
+    void appendFiles(const QList<InputFileInfo> &files);
+    // Removes the given rows (any order, duplicates allowed) in as few model updates as possible
+    void removeRowList(QList<int> rows);
+    void clear();
+
+    const QString &path(int row) const { return m_files.at(row).path; }
+    const InputFileInfo &file(int row) const { return m_files.at(row); }
+
+    static QString formatSize(qint64 bytes);
+    static QString fileName(const QString &path);
+
+private:
+    QList<InputFileInfo> m_files;
+    ThumbnailCache *m_thumbnails = nullptr;
+};
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "InputScanner.h"
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+
+static constexpr qsizetype CHUNK_SIZE = 64;
+static constexpr int FLUSH_INTERVAL_MS = 100;
+
+static constexpr const char *IMAGE_SUFFIXES[] = {
+    "png", "jpg", "jpeg", "bmp", "gif", "tiff", "tif", "webp", "avif"
+};
+// Camera RAW formats, decoded with LibRaw
+static constexpr const char *RAW_SUFFIXES[] = {
+    "cr2", "cr3", "nef", "nrw", "arw", "dng", "raf", "orf", "rw2", "pef", "srw"
+};
+
+InputScanner::InputScanner(QObject *parent)
+    : QObject(parent)
+{
+    m_pool = new QThreadPool(this);
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &InputScanner::flush);
+}
+
+InputScanner::~InputScanner()
+{
+    cancel();
+    m_pool->waitForDone();
+}
+
+const QStringList &InputScanner::nameFilters()
+{
+    static const QStringList FILTERS = [] {
+        QStringList filters;
+        for (const char *suffix : IMAGE_SUFFIXES)
+            filters << QString("*.") + suffix;
+        for (const char *suffix : RAW_SUFFIXES)
+            filters << QString("*.") + suffix;
+        return filters;
+    }();
+    return FILTERS;
+}
+
+bool InputScanner::isRawSuffix(const QString &suffix)
+{
+    static const QSet<QString> RAW = [] {
+        QSet<QString> raw;
+        for (const char *s : RAW_SUFFIXES)
+            raw.insert(QString::fromLatin1(s));
+        return raw;
+    }();
+    return RAW.contains(suffix.toLower());
+}
+
+InputFileInfo InputScanner::probe(const QString &path)
+{
+    InputFileInfo info;
+    info.path = path;
+    info.size = QFileInfo(path).size();
+    // Only the header is read; no pixels are decoded
+    QImageReader reader(path);
+    QSize imgSize = reader.size();
+    if (imgSize.isValid()) {
+        info.width = imgSize.width();
+        info.height = imgSize.height();
+    }
+    return info;
+}
+
+void InputScanner::scan(const QStringList &paths)
+{
+    if (paths.isEmpty()) return;
+
+    int generation = m_generation.load();
+
+    for (qsizetype start = 0; start < paths.size(); start += CHUNK_SIZE) {
+        QStringList chunk = paths.mid(start, CHUNK_SIZE);
+        qint64 sequence;
+        {
+            QMutexLocker lock(&m_mutex);
+            sequence = m_nextChunk++;
+        }
+        m_activeChunks.fetch_add(1);
+        m_pool->start([this, chunk, generation, sequence]() {
+            QList<InputFileInfo> probed;
+            probed.reserve(chunk.size());
+            for (const QString &path : chunk) {
+                if (generation != m_generation.load(std::memory_order_relaxed)) break;
+                probed << probe(path);
+            }
+            {
+                QMutexLocker lock(&m_mutex);
+                if (generation == m_generation)
+                    m_done.insert(sequence, probed);
+            }
+            m_activeChunks.fetch_sub(1);
+        });
+    }
+    m_flushTimer->start();
+}
+
+void InputScanner::cancel()
+{
+    QMutexLocker lock(&m_mutex);
+    ++m_generation;
+    m_done.clear();
+    m_nextFlush = m_nextChunk;
+}
+
+bool InputScanner::isRunning() const
+{
+    return m_flushTimer->isActive();
+}
+
+void InputScanner::flush()
+{
+    // Read the counter before taking the batch so the last chunk's results
+    // are never left behind once it reports done
+    bool idle = (m_activeChunks.load() == 0);
+
+    // Chunks finish in any order; only the run that continues from the last
+    // flush goes out, so rows keep the order the paths were queued in
+    QList<InputFileInfo> batch;
+    {
+        QMutexLocker lock(&m_mutex);
+        for (auto it = m_done.begin(); it != m_done.end() && it.key() == m_nextFlush; it = m_done.erase(it)) {
+            batch += it.value();
+            ++m_nextFlush;
+        }
+    }
+    if (!batch.isEmpty())
+        emit filesScanned(batch);
+
+    if (idle) {
+        m_flushTimer->stop();
+        emit finished();
+    }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+
+class QThreadPool;
+class QTimer;
+
+struct InputFileInfo {
+    QString path;
+    qint64 size = 0;
+    int width = 0;   // 0 when the header could not be read
+    int height = 0;
+};
+
+// Probes file sizes and image dimensions on a background pool and hands the
+// results back to the GUI thread in batches, so adding a large folder never
+// blocks the UI. Batches keep the order the paths were queued in.
+class InputScanner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit InputScanner(QObject *parent = nullptr);
+    ~InputScanner() override;
+
+    // Queues paths for probing; may be called while a scan is running
+    void scan(const QStringList &paths);
+    // Drops all queued and in-flight work; no further batches are delivered for it
+    void cancel();
+    bool isRunning() const;
+
+    // Wildcards for every input type the app can read ("*.png", ...)
+    static const QStringList &nameFilters();
+    // True for the file suffixes of camera RAW formats, in any case
+    static bool isRawSuffix(const QString &suffix);
+    // Reads size and header dimensions of one file; blocking
+    static InputFileInfo probe(const QString &path);
+
+signals:
+    void filesScanned(const QList<InputFileInfo> &files);
+    void finished();
+
+private:
+    void flush();
+
+    QThreadPool *m_pool = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QMutex m_mutex;
+    QMap<qint64, QList<InputFileInfo>> m_done;  // Finished chunks by sequence number, not yet flushed
+    qint64 m_nextChunk = 0;                     // Sequence number of the next chunk queued
+    qint64 m_nextFlush = 0;                     // First chunk not yet flushed
+    std::atomic<int> m_generation{0};      // Bumped on cancel (under m_mutex)
+    std::atomic<int> m_activeChunks{0};
+};
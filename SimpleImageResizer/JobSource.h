@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <memory>
+#include <QString>
+
+#include "ProcessingJob.h"
+
+// One unit of work as produced by a job source, before an output path has
+// been planned for it.
+struct JobEntry {
+    QString inputPath;
+    QString outputDir;                                   // Empty: the batch default
+    std::shared_ptr<const ProcessingSettings> settings;  // Null: the batch settings
+    QString error;                                       // Set if the entry could not be read
+    qint64 fileSize = -1;                                // -1: not known, looked up when scheduling
+    qint64 pixels = 0;                                   // Width x height if already probed, else 0
+    qint64 index = -1;                                   // Position in the source; -1: numbered in order taken
+};
+
+// Supplies a batch with work on demand, so nothing is materialised up front
+// and the scheduler pulls entries only as workers free up. All methods are
+// called from worker threads and must be thread-safe.
+class JobSource {
+public:
+    enum class Status {
+        Ready,     // entry was filled
+        Waiting,   // nothing now, but more may follow (see waitForMore)
+        Exhausted  // no more entries will ever be produced
+    };
+
+    virtual ~JobSource() = default;
+
+    // Never blocks
+    virtual Status next(JobEntry &entry) = 0;
+
+    // Blocks until next() may have something new, cancel() is called or the
+    // timeout passes. Only sources that can return Waiting need this.
+    virtual void waitForMore(int timeoutMs) { Q_UNUSED(timeoutMs); }
+
+    // Wakes waiting workers; next() returns Exhausted from now on
+    virtual void cancel() = 0;
+
+    // Hands out the not-yet-produced entry with this index ahead of its
+    // turn, for the scheduler's priority lane. False if there is none.
+    virtual bool withdraw(qint64 index, JobEntry &entry) { Q_UNUSED(index); Q_UNUSED(entry); return false; }
+
+    // Best guess of how many entries the source produces in total, for progress
+    virtual qint64 estimatedTotal() const = 0;
+};
@@ -0,0 +1,620 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "JpegCodec.h"
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <QColorSpace>
+#include <QFile>
+#include <jpeglib.h>
+
+// QImage::Format_RGB32 is 0xffRRGGBB in native byte order
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+static constexpr J_COLOR_SPACE RGB32_COLOR_SPACE = JCS_EXT_BGRX;
+#else
+static constexpr J_COLOR_SPACE RGB32_COLOR_SPACE = JCS_EXT_XRGB;
+#endif
+
+static constexpr double METERS_PER_INCH = 0.0254;
+static constexpr int ROWS_PER_CHECK = 64;               // Scanlines between cancel checks
+static constexpr qsizetype OUTPUT_BLOCK = 64 * 1024;    // First block of an encoder's output buffer
+
+// Annex K luminance table, which libjpeg scales for every IJG quality
+static constexpr unsigned int STD_LUMINANCE_QUANT[DCTSIZE2] = {
+    16,  11,  10,  16,  24,  40,  51,  61,
+    12,  12,  14,  19,  26,  58,  60,  55,
+    14,  13,  16,  24,  40,  57,  69,  56,
+    14,  17,  22,  29,  51,  87,  80,  62,
+    18,  22,  37,  56,  68, 109, 103,  77,
+    24,  35,  55,  64,  81, 104, 113,  92,
+    49,  64,  78,  87, 103, 121, 120, 101,
+    72,  92,  95,  98, 112, 100, 103,  99
+};
+
+static bool isCancelled(const std::atomic<bool> *cancelFlag)
+{
+    return cancelFlag && cancelFlag->load(std::memory_order_relaxed);
+}
+
+// libjpeg reports errors by calling error_exit, which must not return
+struct JpegError {
+    jpeg_error_mgr pub;
+    std::jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+[[noreturn]] static void onJpegError(j_common_ptr cinfo)
+{
+    auto *error = reinterpret_cast<JpegError *>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, error->message);
+    std::longjmp(error->jump, 1);
+}
+
+// Warnings about damaged data are not worth a line on stderr per file
+static void ignoreJpegMessage(j_common_ptr)
+{
+}
+
+static void initError(JpegError &error)
+{
+    jpeg_std_error(&error.pub);
+    error.pub.error_exit = onJpegError;
+    error.pub.output_message = ignoreJpegMessage;
+    error.message[0] = '\0';
+}
+
+// A libjpeg decompressor that lives as long as the thread that created it.
+// Its permanent allocations are kept between images; jpeg_abort resets
+// the rest once an image is done or has failed.
+struct ThreadDecompressor {
+    JpegError error{};
+    jpeg_decompress_struct cinfo{};
+    bool valid = false;
+
+    ThreadDecompressor()
+    {
+        cinfo.err = &error.pub;
+        initError(error);
+        if (setjmp(error.jump)) return;
+        jpeg_create_decompress(&cinfo);
+        valid = true;
+    }
+    ~ThreadDecompressor()
+    {
+        if (valid) jpeg_destroy_decompress(&cinfo);
+    }
+};
+
+// The compressing counterpart of ThreadDecompressor
+struct ThreadCompressor {
+    JpegError error{};
+    jpeg_compress_struct cinfo{};
+    bool valid = false;
+
+    ThreadCompressor()
+    {
+        cinfo.err = &error.pub;
+        initError(error);
+        if (setjmp(error.jump)) return;
+        jpeg_create_compress(&cinfo);
+        valid = true;
+    }
+    ~ThreadCompressor()
+    {
+        if (valid) jpeg_destroy_compress(&cinfo);
+    }
+};
+
+static ThreadDecompressor &decompressor()
+{
+    thread_local ThreadDecompressor handle;
+    return handle;
+}
+
+static ThreadCompressor &compressor()
+{
+    thread_local ThreadCompressor handle;
+    return handle;
+}
+
+// libjpeg colour space for img's layout. Formats it cannot read are
+// converted to RGB32; alpha is ignored, as by Qt's JPEG writer.
+static J_COLOR_SPACE colorSpaceFor(QImage &img, int &components)
+{
+    components = 4;
+    switch (img.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return RGB32_COLOR_SPACE;
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return JCS_EXT_RGBX;
+    case QImage::Format_RGB888:
+        components = 3;
+        return JCS_EXT_RGB;
+    case QImage::Format_BGR888:
+        components = 3;
+        return JCS_EXT_BGR;
+    case QImage::Format_Grayscale8:
+        components = 1;
+        return JCS_GRAYSCALE;
+    default:
+        img = img.convertToFormat(QImage::Format_RGB32);
+        return RGB32_COLOR_SPACE;
+    }
+}
+
+// Luma sampling factors; chroma stays at 1x1
+static void samplingFor(const ProcessingSettings &settings, int &h, int &v)
+{
+    switch (settings.jpegSubsampling) {
+    case JpegSubsampling::Yuv444: h = 1; v = 1; return;
+    case JpegSubsampling::Yuv422: h = 2; v = 1; return;
+    case JpegSubsampling::Yuv420: break;
+    }
+    h = 2;
+    v = 2;
+}
+
+static QByteArray iccProfileOf(const QImage &img)
+{
+    return img.colorSpace().isValid() ? img.colorSpace().iccProfile() : QByteArray();
+}
+
+bool JpegCodec::isJpeg(const QByteArray &data)
+{
+    return data.size() >= 3 && static_cast<uchar>(data[0]) == 0xFF
+        && static_cast<uchar>(data[1]) == 0xD8 && static_cast<uchar>(data[2]) == 0xFF;
+}
+
+// Reads the header, and the ICC profile if there is one (freed by the
+// caller). The functions that call setjmp here create no C++ objects the
+// jump could skip, and leave the thread's decompressor reset on failure.
+static bool readHeader(ThreadDecompressor &d, const QByteArray &data, JOCTET **icc, unsigned int *iccSize)
+{
+    if (setjmp(d.error.jump)) {
+        jpeg_abort_decompress(&d.cinfo);
+        return false;
+    }
+    jpeg_mem_src(&d.cinfo, reinterpret_cast<const unsigned char *>(data.constData()),
+                 static_cast<unsigned long>(data.size()));
+    jpeg_save_markers(&d.cinfo, JPEG_APP0 + 2, 0xFFFF);
+    jpeg_read_header(&d.cinfo, TRUE);
+    if (!jpeg_read_icc_profile(&d.cinfo, icc, iccSize)) {
+        *icc = nullptr;
+        *iccSize = 0;
+    }
+    return true;
+}
+
+// Decodes into bits a block of rows at a time, checking cancelFlag between
+// blocks. 1: done; 0: cancelled, with the rows so far filled; -1: failed.
+static int readRows(ThreadDecompressor &d, uchar *bits, qsizetype bytesPerLine,
+                    const std::atomic<bool> *cancelFlag)
+{
+    if (setjmp(d.error.jump)) {
+        jpeg_abort_decompress(&d.cinfo);
+        return -1;
+    }
+    jpeg_start_decompress(&d.cinfo);
+    while (d.cinfo.output_scanline < d.cinfo.output_height) {
+        if (isCancelled(cancelFlag)) {
+            jpeg_abort_decompress(&d.cinfo);
+            return 0;
+        }
+        const JDIMENSION end = qMin<JDIMENSION>(d.cinfo.output_scanline + ROWS_PER_CHECK, d.cinfo.output_height);
+        while (d.cinfo.output_scanline < end) {
+            JSAMPROW row = bits + qsizetype(d.cinfo.output_scanline) * bytesPerLine;
+            jpeg_read_scanlines(&d.cinfo, &row, 1);
+        }
+    }
+    jpeg_finish_decompress(&d.cinfo);
+    return 1;
+}
+
+QImage JpegCodec::decode(const QByteArray &data, const std::atomic<bool> *cancelFlag)
+{
+    ThreadDecompressor &d = decompressor();
+    if (!d.valid || !isJpeg(data)) return {};
+    JOCTET *icc = nullptr;
+    unsigned int iccSize = 0;
+    if (!readHeader(d, data, &icc, &iccSize)) return {};
+
+    const J_COLOR_SPACE colorspace = d.cinfo.jpeg_color_space;
+    const bool grey = colorspace == JCS_GRAYSCALE;
+    QImage img;
+    if (colorspace != JCS_CMYK && colorspace != JCS_YCCK)
+        img = QImage(static_cast<int>(d.cinfo.image_width), static_cast<int>(d.cinfo.image_height),
+                     grey ? QImage::Format_Grayscale8 : QImage::Format_RGB32);
+    if (img.isNull()) {
+        std::free(icc);
+        jpeg_abort_decompress(&d.cinfo);
+        return {};
+    }
+    if (icc) {
+        img.setColorSpace(QColorSpace::fromIccProfile(
+            QByteArray(reinterpret_cast<const char *>(icc), static_cast<qsizetype>(iccSize))));
+        std::free(icc);
+    }
+    if (d.cinfo.density_unit == 1) {
+        img.setDotsPerMeterX(qRound(d.cinfo.X_density / METERS_PER_INCH));
+        img.setDotsPerMeterY(qRound(d.cinfo.Y_density / METERS_PER_INCH));
+    }
+
+    // Damaged data only raises a warning and still fills the image, as
+    // with Qt's reader. A cancelled decode returns what it has; callers
+    // check the flag before trusting it.
+    d.cinfo.out_color_space = grey ? JCS_GRAYSCALE : RGB32_COLOR_SPACE;
+    if (readRows(d, img.bits(), img.bytesPerLine(), cancelFlag) < 0) return {};
+    return img;
+}
+
+// Appends the compressed stream to a QByteArray, doubling it as it fills.
+// With maxBytes > 0 the buffer never grows past maxBytes + 1, and filling
+// that much aborts the encode through the error handler.
+struct ByteArrayDestination {
+    jpeg_destination_mgr pub;
+    QByteArray *data;
+    qint64 maxBytes;
+    bool overLimit;
+};
+
+// Next buffer size after used bytes, stopping at the first byte over the cap
+static qsizetype grownSize(const ByteArrayDestination &dest, qsizetype used)
+{
+    const qsizetype wanted = used > 0 ? used * 2 : OUTPUT_BLOCK;
+    return dest.maxBytes > 0 ? qMin<qsizetype>(wanted, dest.maxBytes + 1) : wanted;
+}
+
+static void initDestination(j_compress_ptr cinfo)
+{
+    auto *dest = reinterpret_cast<ByteArrayDestination *>(cinfo->dest);
+    dest->data->resize(grownSize(*dest, 0));
+    dest->pub.next_output_byte = reinterpret_cast<JOCTET *>(dest->data->data());
+    dest->pub.free_in_buffer = static_cast<size_t>(dest->data->size());
+}
+
+static boolean emptyOutputBuffer(j_compress_ptr cinfo)
+{
+    // libjpeg calls this with the whole buffer full
+    auto *dest = reinterpret_cast<ByteArrayDestination *>(cinfo->dest);
+    const qsizetype used = dest->data->size();
+    if (dest->maxBytes > 0 && used > dest->maxBytes) {
+        dest->overLimit = true;
+        (*cinfo->err->error_exit)(reinterpret_cast<j_common_ptr>(cinfo));
+    }
+    dest->data->resize(grownSize(*dest, used));
+    dest->pub.next_output_byte = reinterpret_cast<JOCTET *>(dest->data->data()) + used;
+    dest->pub.free_in_buffer = static_cast<size_t>(dest->data->size() - used);
+    return TRUE;
+}
+
+static void termDestination(j_compress_ptr cinfo)
+{
+    auto *dest = reinterpret_cast<ByteArrayDestination *>(cinfo->dest);
+    dest->data->resize(dest->data->size() - static_cast<qsizetype>(dest->pub.free_in_buffer));
+}
+
+// What one encode writes, gathered before the setjmp in writeRows
+struct EncodeParams {
+    const uchar *bits;
+    qsizetype bytesPerLine;
+    int width;
+    int height;
+    J_COLOR_SPACE colorSpace;
+    int components;
+    int quality;
+    int hSampling;
+    int vSampling;
+    bool fastDct;
+    bool optimize;
+    bool progressive;
+    int densityX;          // Dots per inch, 0 when unknown
+    int densityY;
+    const JOCTET *icc;
+    unsigned int iccSize;
+};
+
+// Compresses a block of rows at a time, checking cancelFlag between
+// blocks. 1: done; 0: cancelled; -1: failed. The compressor is reset
+// whenever it stops early.
+static int writeRows(ThreadCompressor &c, const EncodeParams &p, ByteArrayDestination &dest,
+                     const std::atomic<bool> *cancelFlag)
+{
+    if (setjmp(c.error.jump)) {
+        jpeg_abort_compress(&c.cinfo);
+        return -1;
+    }
+    jpeg_compress_struct &cinfo = c.cinfo;
+    // Parameters stay on the thread's compressor, so every call sets all of them
+    cinfo.image_width = static_cast<JDIMENSION>(p.width);
+    cinfo.image_height = static_cast<JDIMENSION>(p.height);
+    cinfo.input_components = p.components;
+    cinfo.in_color_space = p.colorSpace;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, p.quality, TRUE);
+    if (p.colorSpace != JCS_GRAYSCALE) {
+        cinfo.comp_info[0].h_samp_factor = p.hSampling;
+        cinfo.comp_info[0].v_samp_factor = p.vSampling;
+    }
+    cinfo.dct_method = p.fastDct ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo.optimize_coding = p.optimize ? TRUE : FALSE;
+    if (p.progressive) jpeg_simple_progression(&cinfo);
+    if (p.densityX > 0 && p.densityY > 0) {
+        cinfo.density_unit = 1;
+        cinfo.X_density = static_cast<UINT16>(p.densityX);
+        cinfo.Y_density = static_cast<UINT16>(p.densityY);
+    }
+    cinfo.dest = &dest.pub;
+
+    jpeg_start_compress(&cinfo, TRUE);
+    if (p.iccSize > 0)
+        jpeg_write_icc_profile(&cinfo, p.icc, p.iccSize);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        if (isCancelled(cancelFlag)) {
+            jpeg_abort_compress(&cinfo);
+            return 0;
+        }
+        const JDIMENSION end = qMin<JDIMENSION>(cinfo.next_scanline + ROWS_PER_CHECK, cinfo.image_height);
+        while (cinfo.next_scanline < end) {
+            JSAMPROW row = const_cast<uchar *>(p.bits + qsizetype(cinfo.next_scanline) * p.bytesPerLine);
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+    }
+    jpeg_finish_compress(&cinfo);
+    return 1;
+}
+
+ResultStatus JpegCodec::encode(const QImage &img, const ProcessingSettings &settings, int quality,
+                               const std::atomic<bool> *cancelFlag, QByteArray &data, QString &errorMessage,
+                               qint64 maxBytes)
+{
+    ThreadCompressor &c = compressor();
+    if (!c.valid) {
+        errorMessage = "Failed to create JPEG encoder";
+        return ResultStatus::FailedToSave;
+    }
+    QImage pixels = img;
+    EncodeParams p{};
+    p.colorSpace = colorSpaceFor(pixels, p.components);
+    p.bits = pixels.constBits();
+    p.bytesPerLine = pixels.bytesPerLine();
+    p.width = pixels.width();
+    p.height = pixels.height();
+    p.quality = quality;
+    samplingFor(settings, p.hSampling, p.vSampling);
+    p.fastDct = settings.jpegFastDct;
+    p.optimize = settings.jpegOptimizeCoding;
+    p.progressive = settings.jpegProgressive;
+    if (pixels.dotsPerMeterX() > 0 && pixels.dotsPerMeterY() > 0) {
+        p.densityX = qRound(pixels.dotsPerMeterX() * METERS_PER_INCH);
+        p.densityY = qRound(pixels.dotsPerMeterY() * METERS_PER_INCH);
+    }
+    const QByteArray icc = iccProfileOf(pixels);
+    p.icc = reinterpret_cast<const JOCTET *>(icc.constData());
+    p.iccSize = static_cast<unsigned int>(icc.size());
+
+    QByteArray output;
+    ByteArrayDestination dest{};
+    dest.pub.init_destination = initDestination;
+    dest.pub.empty_output_buffer = emptyOutputBuffer;
+    dest.pub.term_destination = termDestination;
+    dest.data = &output;
+    dest.maxBytes = maxBytes;
+
+    switch (writeRows(c, p, dest, cancelFlag)) {
+    case 1:
+        data = output;
+        return ResultStatus::Success;
+    case 0:
+        return ResultStatus::Cancelled;
+    default:
+        if (dest.overLimit) return ResultStatus::KeptOriginal;
+        errorMessage = QString("Failed to encode JPEG: ") + QString::fromLatin1(c.error.message);
+        return ResultStatus::FailedToSave;
+    }
+}
+
+// Copies the first quantisation table out of a JPEG's header. Creates no
+// C++ objects, so the error jump skips no destructors.
+static bool readLuminanceTable(const unsigned char *jpeg, size_t size, unsigned int table[DCTSIZE2])
+{
+    JpegError error{};
+    jpeg_decompress_struct cinfo{};
+    cinfo.err = &error.pub;
+    initError(error);
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg, static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+    const JQUANT_TBL *luma = cinfo.quant_tbl_ptrs[0];
+    if (luma) {
+        for (int k = 0; k < DCTSIZE2; ++k)
+            table[k] = luma->quantval[k];
+    }
+    jpeg_destroy_decompress(&cinfo);
+    return luma != nullptr;
+}
+
+int JpegCodec::estimateQuality(const QString &path)
+{
+    // Mapped rather than read, so only the header's pages are touched
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return -1;
+    const qint64 size = file.size();
+    const uchar *jpeg = size > 0 ? file.map(0, size) : nullptr;
+    if (!jpeg) return -1;
+    unsigned int table[DCTSIZE2];
+    if (!readLuminanceTable(jpeg, static_cast<size_t>(size), table)) return -1;
+
+    // Undo libjpeg's scaling: the table is the standard one times S / 100,
+    // with S = 5000 / q below quality 50 and 200 - 2q above it
+    double scale = 0.0;
+    for (int k = 0; k < DCTSIZE2; ++k)
+        scale += 100.0 * table[k] / STD_LUMINANCE_QUANT[k];
+    scale /= DCTSIZE2;
+    if (scale <= 0.0) return 100;
+    const double quality = scale <= 100.0 ? (200.0 - scale) / 2.0 : 5000.0 / scale;
+    return qBound(1, qRound(quality), 100);
+}
+
+static JCOEF requantize(int value, int step)
+{
+    return static_cast<JCOEF>(value >= 0 ? (value + step / 2) / step : -((-value + step / 2) / step));
+}
+
+// The quality-100 coefficients of one image. libjpeg keeps them in the
+// decompressor's block arrays; each probe overwrites those with the
+// requantized copy and hands them to a compressor that writes new tables.
+// Functions that call setjmp create no C++ objects the jump could skip.
+struct JpegCodec::QualityProbe::Coefficients {
+    bool optimize = true;
+    bool progressive = false;
+    QByteArray base;  // Quality-100 JPEG the block arrays were read from
+    QByteArray icc;
+    bool valid = false;
+
+    JpegError srcError{};
+    JpegError dstError{};
+    jpeg_decompress_struct src{};
+    jpeg_compress_struct dst{};
+    bool srcCreated = false;
+    bool dstCreated = false;
+    jvirt_barray_ptr *arrays = nullptr;
+    std::vector<std::vector<JCOEF>> original;  // Per component, in block order
+    unsigned char *output = nullptr;           // Allocated by jpeg_mem_dest
+    unsigned long outputSize = 0;
+
+    ~Coefficients()
+    {
+        if (dstCreated) jpeg_destroy_compress(&dst);
+        if (srcCreated) jpeg_destroy_decompress(&src);
+        std::free(output);
+    }
+
+    bool readBase()
+    {
+        src.err = jpeg_std_error(&srcError.pub);
+        srcError.pub.error_exit = onJpegError;
+        dst.err = jpeg_std_error(&dstError.pub);
+        dstError.pub.error_exit = onJpegError;
+
+        if (setjmp(dstError.jump)) return false;
+        jpeg_create_compress(&dst);
+        dstCreated = true;
+
+        if (setjmp(srcError.jump)) return false;
+        jpeg_create_decompress(&src);
+        srcCreated = true;
+        jpeg_mem_src(&src, reinterpret_cast<const unsigned char *>(base.constData()),
+                     static_cast<unsigned long>(base.size()));
+        jpeg_read_header(&src, TRUE);
+        arrays = jpeg_read_coefficients(&src);
+
+        original.resize(src.num_components);
+        for (int ci = 0; ci < src.num_components; ++ci) {
+            const jpeg_component_info &comp = src.comp_info[ci];
+            original[ci].resize(static_cast<size_t>(comp.width_in_blocks) * comp.height_in_blocks * DCTSIZE2);
+            JCOEF *out = original[ci].data();
+            for (JDIMENSION row = 0; row < comp.height_in_blocks; ++row) {
+                JBLOCKARRAY blocks = (*src.mem->access_virt_barray)(
+                    reinterpret_cast<j_common_ptr>(&src), arrays[ci], row, 1, FALSE);
+                std::memcpy(out, blocks[0], comp.width_in_blocks * sizeof(JBLOCK));
+                out += comp.width_in_blocks * DCTSIZE2;
+            }
+        }
+        return true;
+    }
+
+    // Requantizes the base coefficients with dst's tables into the block arrays
+    void requantizeInto()
+    {
+        for (int ci = 0; ci < src.num_components; ++ci) {
+            const jpeg_component_info &comp = src.comp_info[ci];
+            const JQUANT_TBL *from = comp.quant_table;
+            const JQUANT_TBL *to = dst.quant_tbl_ptrs[comp.quant_tbl_no];
+            const JCOEF *in = original[ci].data();
+            for (JDIMENSION row = 0; row < comp.height_in_blocks; ++row) {
+                JBLOCKARRAY blocks = (*src.mem->access_virt_barray)(
+                    reinterpret_cast<j_common_ptr>(&src), arrays[ci], row, 1, TRUE);
+                for (JDIMENSION b = 0; b < comp.width_in_blocks; ++b, in += DCTSIZE2) {
+                    for (int k = 0; k < DCTSIZE2; ++k)
+                        blocks[0][b][k] = requantize(in[k] * from->quantval[k], to->quantval[k]);
+                }
+            }
+        }
+    }
+
+    // On success the caller copies output and frees it
+    bool write(int quality)
+    {
+        if (setjmp(dstError.jump)) {
+            jpeg_abort_compress(&dst);
+            return false;
+        }
+        jpeg_copy_critical_parameters(&src, &dst);
+        jpeg_set_quality(&dst, quality, TRUE);
+        dst.optimize_coding = optimize ? TRUE : FALSE;
+        if (progressive) jpeg_simple_progression(&dst);
+        dst.density_unit = src.density_unit;
+        dst.X_density = src.X_density;
+        dst.Y_density = src.Y_density;
+        requantizeInto();
+
+        jpeg_mem_dest(&dst, &output, &outputSize);
+        jpeg_write_coefficients(&dst, arrays);
+        if (!icc.isEmpty())
+            jpeg_write_icc_profile(&dst, reinterpret_cast<const JOCTET *>(icc.constData()),
+                                   static_cast<unsigned int>(icc.size()));
+        jpeg_finish_compress(&dst);
+        return true;
+    }
+};
+
+JpegCodec::QualityProbe::QualityProbe(const QImage &img, const ProcessingSettings &settings,
+                                      const std::atomic<bool> *cancelFlag)
+    : d(std::make_unique<Coefficients>())
+{
+    d->optimize = settings.jpegOptimizeCoding || settings.jpegProgressive;
+    d->progressive = settings.jpegProgressive;
+    d->icc = iccProfileOf(img);
+
+    // The base pass only needs to be exact and quick; probes pick the coding
+    ProcessingSettings baseSettings = settings;
+    baseSettings.jpegOptimizeCoding = false;
+    baseSettings.jpegProgressive = false;
+    QString error;
+    if (JpegCodec::encode(img, baseSettings, 100, cancelFlag, d->base, error) != ResultStatus::Success) return;
+    d->valid = d->readBase();
+}
+
+JpegCodec::QualityProbe::~QualityProbe() = default;
+
+bool JpegCodec::QualityProbe::isValid() const
+{
+    return d->valid;
+}
+
+bool JpegCodec::QualityProbe::encode(int quality, QByteArray &data, QString &errorMessage)
+{
+    std::free(d->output);
+    d->output = nullptr;
+    d->outputSize = 0;
+    if (!d->valid || !d->write(quality)) {
+        errorMessage = QString("Failed to encode JPEG at quality %1: %2")
+                           .arg(quality).arg(QString::fromLatin1(d->dstError.message));
+        return false;
+    }
+    data = QByteArray(reinterpret_cast<const char *>(d->output), static_cast<qsizetype>(d->outputSize));
+    std::free(d->output);
+    d->output = nullptr;
+    return true;
+}
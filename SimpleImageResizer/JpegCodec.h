@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+#include "ProcessingJob.h"
+#include "ProcessingResult.h"
+
+// Native JPEG backend on libjpeg-turbo. Decodes and encodes straight
+// between QImage memory and the compressed bytes through libjpeg's scanline
+// API, with one compressor and decompressor per thread reused across
+// images, and exposes the encoder options Qt's writer hides (subsampling,
+// optimised Huffman tables, progressive scans, fast DCT). Both directions
+// check cancelFlag every few dozen rows, and an encode stops with
+// KeptOriginal as soon as its output passes maxBytes (if > 0).
+class JpegCodec {
+public:
+    static bool isJpeg(const QByteArray &data);
+    // Null for anything libjpeg cannot decode to RGB or grey (e.g. CMYK),
+    // which is left to Qt's reader. A cancelled decode returns the rows read
+    // so far; callers check the flag before trusting the image.
+    static QImage decode(const QByteArray &data, const std::atomic<bool> *cancelFlag = nullptr);
+    static ResultStatus encode(const QImage &img, const ProcessingSettings &settings, int quality,
+                               const std::atomic<bool> *cancelFlag, QByteArray &data, QString &errorMessage,
+                               qint64 maxBytes = 0);
+    // The IJG quality (1-100) the JPEG at path was most likely saved at,
+    // estimated from its luminance quantisation table; -1 if it cannot be read
+    static int estimateQuality(const QString &path);
+
+    // Encodes one image at many qualities for a target-size search. The
+    // colour conversion, subsampling and DCT run once, into quality-100
+    // coefficients; each probe only requantizes them and entropy codes.
+    class QualityProbe {
+    public:
+        // cancelFlag stops the base pass; the probe is then invalid
+        QualityProbe(const QImage &img, const ProcessingSettings &settings,
+                     const std::atomic<bool> *cancelFlag = nullptr);
+        ~QualityProbe();
+
+        QualityProbe(const QualityProbe &) = delete;
+        QualityProbe &operator=(const QualityProbe &) = delete;
+
+        // False if the base pass failed; callers then encode each probe in full
+        bool isValid() const;
+        bool encode(int quality, QByteArray &data, QString &errorMessage);
+
+    private:
+        struct Coefficients;
+        std::unique_ptr<Coefficients> d;
+    };
+};
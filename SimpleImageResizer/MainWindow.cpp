@@ -2,9 +2,16 @@
 // Copyright (C) 2024-2026 thanolion
 
 #include "MainWindow.h"
+#include "BatchScheduler.h"
+#include "DirectoryWalker.h"
 #include "FormatGuideDialog.h"
-#include "ImageProcessor.h"
+#include "ManifestJobSource.h"
+#include "PreviewPanel.h"
+#include "ReportWriter.h"
+#include "ResumeJobSource.h"
 #include "SettingsManager.h"
+#include "TableJobSource.h"
+#include "ThumbnailCache.h"
 
 //All the QT framework includes
 #include <QApplication>
@@ -25,29 +32,37 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QCloseEvent>
-#include <QtConcurrent>
 #include <QDir>
 #include <QFileInfo>
 #include <QSet>
-#include <QDirIterator>
-#include <QImageReader>
 #include <QSignalBlocker>
-
-static const QStringList IMAGE_FILTERS = {
-    "*.png", "*.jpg", "*.jpeg", "*.bmp", "*.gif", "*.tiff", "*.tif", "*.webp", "*.avif",
-    "*.cr2", "*.cr3", "*.nef", "*.nrw", "*.arw", "*.dng", "*.raf", "*.orf", "*.rw2", "*.pef", "*.srw"
-};
+#include <algorithm>
+#include <limits>
 
 static QString buildDialogFilter() {
-    return "Images (" + IMAGE_FILTERS.join(' ') + ");;All Files (*)";
+    return "Images (" + InputScanner::nameFilters().join(' ') + ");;All Files (*)";
 }
 
 static QStringList bareExtensions() {
     QStringList exts;
-    for (const QString &f : IMAGE_FILTERS) exts << f.mid(2); // "*.png" -> "png"
+    for (const QString &f : InputScanner::nameFilters()) exts << f.mid(2); // "*.png" -> "png"
     return exts;
 }
 
+static QList<int> consecutiveRows(int first, qsizetype count) {
+    QList<int> rows;
+    rows.reserve(count);
+    for (qsizetype i = 0; i < count; ++i) rows << first + static_cast<int>(i);
+    return rows;
+}
+
+static QStringList pathsOf(const QList<InputFileInfo> &files) {
+    QStringList paths;
+    paths.reserve(files.size());
+    for (const InputFileInfo &file : files) paths << file.path;
+    return paths;
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
@@ -58,24 +73,44 @@ MainWindow::MainWindow(QWidget *parent)
     setupMenuBar();
     setupUI();
     m_threadPool = new QThreadPool(this);
+    m_scanner = new InputScanner(this);
+    connect(m_scanner, &InputScanner::filesScanned, this, &MainWindow::onFilesScanned);
+    connect(m_scanner, &InputScanner::finished, this, &MainWindow::closeTableSourceIfIdle);
+    m_walker = new DirectoryWalker(InputScanner::nameFilters(), this);
+    connect(m_walker, &DirectoryWalker::filesFound, this, &MainWindow::addImageFiles);
+    connect(m_walker, &DirectoryWalker::progress, this, &MainWindow::onWalkProgress);
+    connect(m_walker, &DirectoryWalker::finished, this, &MainWindow::onWalkFinished);
+    m_scheduler = new BatchScheduler(m_threadPool, this);
+    connect(m_scheduler, &BatchScheduler::finished, this, &MainWindow::onProcessingFinished);
+    m_dispatcher.addSink(m_resultsModel);
+    m_dispatcher.addSink(&m_stats);
+    m_uiUpdateTimer = new QTimer(this);
+    m_uiUpdateTimer->setInterval(50);
+    connect(m_uiUpdateTimer, &QTimer::timeout, this, &MainWindow::flushUiUpdates);
     loadSettings();
     syncAdvancedToSimple();
+    updatePreviewSettings();
 }
 
 MainWindow::~MainWindow()
 {
-    // Safety net — closeEvent should have already handled this
-    if (m_watcher && m_watcher->isRunning()) {
-        m_cancelled = true;
-        m_watcher->disconnect();
-        m_watcher->cancel();
-        m_watcher->waitForFinished();
-    }
+    // Safety net — closeEvent should have already handled this. Workers
+    // push into m_dispatcher, so they must stop before it is destroyed.
+    m_scheduler->cancel();
+    m_scheduler->waitForDone();
 }
 
 void MainWindow::setupMenuBar()
 {
     auto *fileMenu = menuBar()->addMenu("&File");
+    m_processManifestAction = fileMenu->addAction("Process &Manifest...");
+    m_processManifestAction->setToolTip("Process the files listed in a text or JSON Lines manifest");
+    connect(m_processManifestAction, &QAction::triggered, this, &MainWindow::onProcessManifest);
+    m_resumeAction = fileMenu->addAction("&Resume Interrupted Batch");
+    m_resumeAction->setToolTip("Continue the last batch that was closed or crashed, skipping finished files");
+    m_resumeAction->setEnabled(QFile::exists(BatchJournal::defaultPath()));
+    connect(m_resumeAction, &QAction::triggered, this, &MainWindow::onResumeBatch);
+    fileMenu->addSeparator();
     auto *exitAction = fileMenu->addAction("E&xit");
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
 
@@ -103,13 +138,24 @@ void MainWindow::setupUI()
     auto *inputGroup = new QGroupBox("Input Files");
     auto *inputLayout = new QVBoxLayout(inputGroup);
 
-    m_inputTable = new QTableWidget(0, 3);
-    m_inputTable->setHorizontalHeaderLabels({"File Name", "Size", "Dimensions"});
-    m_inputTable->horizontalHeader()->setStretchLastSection(true);
-    m_inputTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    m_inputTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_inputModel = new InputFileModel(this);
+    m_thumbnails = new ThumbnailCache(this);
+    m_inputModel->setThumbnailCache(m_thumbnails);
+    m_inputTable = new QTableView;
+    m_inputTable->setModel(m_inputModel);
+    configureTableView(m_inputTable);
+    // Rows tall enough for a thumbnail; still fixed so scrolling stays cheap
+    m_inputTable->setIconSize(QSize(32, 32));
+    m_inputTable->verticalHeader()->setDefaultSectionSize(qMax(36, m_inputTable->fontMetrics().height() + 6));
     inputLayout->addWidget(m_inputTable);
 
+    // Runs the selected rows ahead of the rest of a batch, or on their own
+    m_processNowAction = new QAction("Process Now", this);
+    m_processNowAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_Return));
+    m_processNowAction->setShortcutContext(Qt::WidgetShortcut);
+    m_inputTable->addAction(m_processNowAction);
+    m_inputTable->setContextMenuPolicy(Qt::ActionsContextMenu);
+
     auto *inputBtnLayout = new QHBoxLayout;
     m_addFilesBtn = new QPushButton("Add Files...");
     m_addFolderBtn = new QPushButton("Add Folder...");
@@ -151,13 +197,10 @@ void MainWindow::setupUI()
     auto *resultsGroup = new QGroupBox("Results");
     auto *resultsLayout = new QVBoxLayout(resultsGroup);
 
-    m_resultsTable = new QTableWidget(0, 5);
-    m_resultsTable->setHorizontalHeaderLabels({
-        "File Name", "Original Size", "New Size", "Reduction %", "Status"
-    });
-    m_resultsTable->horizontalHeader()->setStretchLastSection(true);
-    m_resultsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    m_resultsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_resultsModel = new ResultsModel(this);
+    m_resultsTable = new QTableView;
+    m_resultsTable->setModel(m_resultsModel);
+    configureTableView(m_resultsTable);
     resultsLayout->addWidget(m_resultsTable);
 
     auto *resultsBtnLayout = new QHBoxLayout;
@@ -168,7 +211,16 @@ void MainWindow::setupUI()
     resultsBtnLayout->addStretch();
     resultsLayout->addLayout(resultsBtnLayout);
 
-    rightLayout->addWidget(resultsGroup);
+    // Before/after preview of the selected input with the current settings
+    auto *previewGroup = new QGroupBox("Preview");
+    auto *previewLayout = new QVBoxLayout(previewGroup);
+    m_previewPanel = new PreviewPanel;
+    previewLayout->addWidget(m_previewPanel);
+
+    auto *rightSplitter = new QSplitter(Qt::Vertical);
+    rightSplitter->addWidget(resultsGroup);
+    rightSplitter->addWidget(previewGroup);
+    rightLayout->addWidget(rightSplitter);
 
     splitter->addWidget(leftWidget);
     splitter->addWidget(rightWidget);
@@ -181,6 +233,7 @@ void MainWindow::setupUI()
     connect(m_removeSelectedBtn, &QPushButton::clicked, this, &MainWindow::onRemoveSelected);
     connect(m_clearAllBtn, &QPushButton::clicked, this, &MainWindow::onClearAll);
     connect(m_processBtn, &QPushButton::clicked, this, &MainWindow::onProcess);
+    connect(m_processNowAction, &QAction::triggered, this, &MainWindow::onProcessNow);
     connect(m_cancelBtn, &QPushButton::clicked, this, &MainWindow::onCancel);
     connect(m_copyResultsBtn, &QPushButton::clicked, this, &MainWindow::onCopyResults);
     connect(m_openOutputBtn, &QPushButton::clicked, this, &MainWindow::onOpenOutputFolder);
@@ -190,9 +243,59 @@ void MainWindow::setupUI()
         else            syncSimpleToAdvanced();
     });
 
+    // Preview follows the current input row and every setting that affects the output
+    connect(m_inputTable->selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+            [this](const QModelIndex &current) {
+        m_previewPanel->setImage(current.isValid() ? m_inputModel->path(current.row()) : QString());
+    });
+    auto advancedChanged = [this]() { updatePreviewSettings(); };
+    connect(m_qualitySlider, &QSlider::valueChanged, this, advancedChanged);
+    connect(m_resizeSlider, &QSlider::valueChanged, this, advancedChanged);
+    connect(m_widthSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, advancedChanged);
+    connect(m_heightSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, advancedChanged);
+    connect(m_targetSizeCheck, &QCheckBox::toggled, this, advancedChanged);
+    connect(m_targetSizeSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, advancedChanged);
+    connect(m_fmtGroup, &QButtonGroup::idClicked, this, advancedChanged);
+    connect(m_jpegSubsamplingCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, advancedChanged);
+    connect(m_jpegOptimizeCheck, &QCheckBox::toggled, this, advancedChanged);
+    connect(m_jpegProgressiveCheck, &QCheckBox::toggled, this, advancedChanged);
+    connect(m_jpegFastDctCheck, &QCheckBox::toggled, this, advancedChanged);
+    connect(m_webpSpeedCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, advancedChanged);
+    connect(m_avifSpeedCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, advancedChanged);
+    connect(m_avifBudgetSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [this](double seconds) {
+        // A budget picks the speed itself
+        m_avifSpeedCombo->setEnabled(seconds <= 0.0);
+    });
+    connect(m_avifBudgetSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, advancedChanged);
+    connect(m_modeGroup, &QButtonGroup::idClicked, this, advancedChanged);
+    auto simpleChanged = [this]() {
+        if (m_tabWidget->currentIndex() == 0) syncSimpleToAdvanced();
+        updatePreviewSettings();
+    };
+    connect(m_simpleFormatCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, simpleChanged);
+    connect(m_simpleResizeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, simpleChanged);
+    connect(m_simpleQualityCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, simpleChanged);
+    connect(m_simpleResizeSlider, &QSlider::valueChanged, this, simpleChanged);
+
     updateResizeControls();
 }
 
+void MainWindow::updatePreviewSettings()
+{
+    m_previewPanel->setSettings(settingsFromControls());
+}
+
+void MainWindow::configureTableView(QTableView *view)
+{
+    view->horizontalHeader()->setStretchLastSection(true);
+    view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setWordWrap(false);
+    // Uniform row heights keep scrolling cheap with very large row counts
+    view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    view->verticalHeader()->setDefaultSectionSize(view->fontMetrics().height() + 6);
+}
+
 void MainWindow::setupSimpleTab(QTabWidget *tabWidget)
 {
     auto *page = new QWidget;
@@ -219,6 +322,7 @@ void MainWindow::setupSimpleTab(QTabWidget *tabWidget)
     m_simpleFormatCombo->addItem("PNG - Lossless quality", 1);
     m_simpleFormatCombo->addItem("WebP - Smaller than JPG", 2);
     m_simpleFormatCombo->addItem("AVIF - Smallest files", 3);
+    m_simpleFormatCombo->addItem("Auto - Best per image", 4);
     m_simpleFormatCombo->setMinimumWidth(200);
     m_simpleFormatCombo->setToolTip("Choose the output image format");
     fmtLayout->addWidget(m_simpleFormatCombo);
@@ -350,18 +454,50 @@ void MainWindow::setupAdvancedTab(QTabWidget *tabWidget)
     m_fmtPng = new QRadioButton("PNG");
     m_fmtWebp = new QRadioButton("WebP");
     m_fmtAvif = new QRadioButton("AVIF");
+    m_fmtAuto = new QRadioButton("Auto");
+    m_fmtAuto->setToolTip("Pick the format per image from its content and keep the smaller of the two likeliest");
     m_fmtJpg->setChecked(true);
     m_fmtGroup = new QButtonGroup(this);
     m_fmtGroup->addButton(m_fmtJpg, 0);
     m_fmtGroup->addButton(m_fmtPng, 1);
     m_fmtGroup->addButton(m_fmtWebp, 2);
     m_fmtGroup->addButton(m_fmtAvif, 3);
+    m_fmtGroup->addButton(m_fmtAuto, 4);
     fmtLayout->addWidget(m_fmtJpg);
     fmtLayout->addWidget(m_fmtPng);
     fmtLayout->addWidget(m_fmtWebp);
     fmtLayout->addWidget(m_fmtAvif);
+    fmtLayout->addWidget(m_fmtAuto);
     fmtLayout->addStretch();
     outputLayout->addLayout(fmtLayout);
+
+    auto *passthroughLayout = new QHBoxLayout;
+    passthroughLayout->addWidget(new QLabel("Unchanged Files:"));
+    m_passthroughCombo = new QComboBox;
+    m_passthroughCombo->addItem("Re-encode", static_cast<int>(Passthrough::Off));
+    m_passthroughCombo->addItem("Copy", static_cast<int>(Passthrough::Copy));
+    m_passthroughCombo->addItem("Hard Link", static_cast<int>(Passthrough::Link));
+    m_passthroughCombo->setToolTip("Inputs already in the output format that need no resize (and are within the "
+                                   "target size, or for JPEG no higher a quality than set) are copied as they "
+                                   "are, keeping their quality and metadata");
+    passthroughLayout->addWidget(m_passthroughCombo);
+    m_neverLargerCheck = new QCheckBox("Never larger than original");
+    m_neverLargerCheck->setToolTip("Stop an encode as soon as it grows past the original's size and keep the "
+                                   "original instead (copied when it is already in the output format)");
+    passthroughLayout->addWidget(m_neverLargerCheck);
+    passthroughLayout->addStretch();
+    outputLayout->addLayout(passthroughLayout);
+
+    auto *reportLayout = new QHBoxLayout;
+    reportLayout->addWidget(new QLabel("Report:"));
+    m_reportFormatCombo = new QComboBox;
+    m_reportFormatCombo->addItem("None", static_cast<int>(ReportWriter::Format::None));
+    m_reportFormatCombo->addItem("CSV", static_cast<int>(ReportWriter::Format::Csv));
+    m_reportFormatCombo->addItem("JSON Lines", static_cast<int>(ReportWriter::Format::JsonLines));
+    m_reportFormatCombo->setToolTip("Write a per-file report into the output folder as the batch runs");
+    reportLayout->addWidget(m_reportFormatCombo);
+    reportLayout->addStretch();
+    outputLayout->addLayout(reportLayout);
     layout->addWidget(outputGroup);
 
     // ── Resize Options ──
@@ -441,6 +577,68 @@ void MainWindow::setupAdvancedTab(QTabWidget *tabWidget)
     targetRow->addStretch();
     qualityLayout->addLayout(targetRow);
 
+    m_jpegOptions = new QWidget;
+    auto *jpegRow = new QHBoxLayout(m_jpegOptions);
+    jpegRow->setContentsMargins(0, 0, 0, 0);
+    jpegRow->addWidget(new QLabel("JPEG Chroma:"));
+    m_jpegSubsamplingCombo = new QComboBox;
+    m_jpegSubsamplingCombo->addItem("4:2:0", static_cast<int>(JpegSubsampling::Yuv420));
+    m_jpegSubsamplingCombo->addItem("4:2:2", static_cast<int>(JpegSubsampling::Yuv422));
+    m_jpegSubsamplingCombo->addItem("4:4:4", static_cast<int>(JpegSubsampling::Yuv444));
+    m_jpegSubsamplingCombo->setToolTip("Colour resolution. 4:2:0 gives the smallest files; "
+                                       "4:4:4 keeps sharp coloured edges and text");
+    jpegRow->addWidget(m_jpegSubsamplingCombo);
+    m_jpegOptimizeCheck = new QCheckBox("Optimize");
+    m_jpegOptimizeCheck->setChecked(true);
+    m_jpegOptimizeCheck->setToolTip("Builds Huffman tables for each image: a few percent smaller at no quality cost");
+    jpegRow->addWidget(m_jpegOptimizeCheck);
+    m_jpegProgressiveCheck = new QCheckBox("Progressive");
+    m_jpegProgressiveCheck->setToolTip("Loads coarse-to-fine in browsers and is usually smaller, but slower to encode");
+    jpegRow->addWidget(m_jpegProgressiveCheck);
+    m_jpegFastDctCheck = new QCheckBox("Fast DCT");
+    m_jpegFastDctCheck->setToolTip("Faster encoding with a slightly less accurate transform");
+    jpegRow->addWidget(m_jpegFastDctCheck);
+    jpegRow->addStretch();
+    qualityLayout->addWidget(m_jpegOptions);
+
+    m_webpOptions = new QWidget;
+    auto *webpRow = new QHBoxLayout(m_webpOptions);
+    webpRow->setContentsMargins(0, 0, 0, 0);
+    webpRow->addWidget(new QLabel("WebP Effort:"));
+    m_webpSpeedCombo = new QComboBox;
+    m_webpSpeedCombo->addItem("Fast", static_cast<int>(WebpSpeed::Fast));
+    m_webpSpeedCombo->addItem("Balanced", static_cast<int>(WebpSpeed::Balanced));
+    m_webpSpeedCombo->addItem("Smallest", static_cast<int>(WebpSpeed::Smallest));
+    m_webpSpeedCombo->setCurrentIndex(1);
+    m_webpSpeedCombo->setToolTip("How hard the encoder searches for a smaller file at the same quality");
+    webpRow->addWidget(m_webpSpeedCombo);
+    webpRow->addStretch();
+    qualityLayout->addWidget(m_webpOptions);
+
+    m_avifOptions = new QWidget;
+    auto *avifRow = new QHBoxLayout(m_avifOptions);
+    avifRow->setContentsMargins(0, 0, 0, 0);
+    avifRow->addWidget(new QLabel("AVIF Speed:"));
+    m_avifSpeedCombo = new QComboBox;
+    m_avifSpeedCombo->addItem("Fast", static_cast<int>(AvifSpeed::Fast));
+    m_avifSpeedCombo->addItem("Balanced", static_cast<int>(AvifSpeed::Balanced));
+    m_avifSpeedCombo->addItem("Best", static_cast<int>(AvifSpeed::Best));
+    m_avifSpeedCombo->setCurrentIndex(1);
+    m_avifSpeedCombo->setToolTip("Best gives the smallest files but encodes several times slower than Balanced");
+    avifRow->addWidget(m_avifSpeedCombo);
+    avifRow->addWidget(new QLabel("Time Budget:"));
+    m_avifBudgetSpin = new QDoubleSpinBox;
+    m_avifBudgetSpin->setRange(0.0, 600.0);
+    m_avifBudgetSpin->setSingleStep(0.5);
+    m_avifBudgetSpin->setDecimals(1);
+    m_avifBudgetSpin->setSuffix(" s");
+    m_avifBudgetSpin->setSpecialValueText("Off");
+    m_avifBudgetSpin->setToolTip("Encode each image within this time: the slowest speed predicted to fit is "
+                                 "picked from image size and the encode times measured so far");
+    avifRow->addWidget(m_avifBudgetSpin);
+    avifRow->addStretch();
+    qualityLayout->addWidget(m_avifOptions);
+
     m_pngInfoLabel = new QLabel("PNG uses lossless compression \u2014 quality and target size settings do not apply.");
     m_pngInfoLabel->setStyleSheet("QLabel { color: #666; font-style: italic; padding: 2px 0; }");
     m_pngInfoLabel->setWordWrap(true);
@@ -458,19 +656,34 @@ void MainWindow::setupAdvancedTab(QTabWidget *tabWidget)
     int maxThreads = QThread::idealThreadCount();
     m_threadCountSpin->setRange(1, maxThreads);
     m_threadCountSpin->setValue(qMax(1, maxThreads - 1));
-    m_threadCountSpin->setToolTip("Controls how many images are processed in parallel. "
+    m_threadCountSpin->setToolTip("Controls how many images are decoded, resized and encoded in parallel. "
                                    "Using all threads may make the system less responsive during processing.");
     threadRow->addWidget(m_threadCountSpin);
+    threadRow->addSpacing(20);
+    threadRow->addWidget(new QLabel("Files in Flight:"));
+    m_ioConcurrencySpin = new QSpinBox;
+    m_ioConcurrencySpin->setRange(1, 256);
+    m_ioConcurrencySpin->setValue(qMax(1, maxThreads - 1));
+    m_ioConcurrencySpin->setToolTip("Controls how many files are read or written at the same time. "
+                                     "Raise this for network shares to hide latency; lower it for slow disks.");
+    threadRow->addWidget(m_ioConcurrencySpin);
     threadRow->addStretch();
     perfLayout->addLayout(threadRow);
 
     auto *threadDesc = new QLabel(
-        QString("Number of CPU threads used for image processing. Lower values leave more "
-                "resources for other applications. Default: %1 of %2 available.")
+        QString("CPU threads limit concurrent decoding and encoding. Lower values leave more "
+                "resources for other applications. Default: %1 of %2 available. "
+                "Files in flight limits concurrent reads and writes; upcoming inputs are "
+                "prefetched so storage latency overlaps with encoding.")
             .arg(qMax(1, maxThreads - 1)).arg(maxThreads));
     threadDesc->setStyleSheet("QLabel { color: #666; font-style: italic; padding: 2px 0; }");
     threadDesc->setWordWrap(true);
     perfLayout->addWidget(threadDesc);
+
+    m_isolatedWorkersCheck = new QCheckBox("Process in separate worker processes");
+    m_isolatedWorkersCheck->setToolTip("Runs one helper process per CPU thread. A file that crashes a decoder "
+                                       "is reported as failed instead of closing the application.");
+    perfLayout->addWidget(m_isolatedWorkersCheck);
     layout->addWidget(perfGroup);
 
     tabWidget->addTab(page, "Advanced");
@@ -489,9 +702,16 @@ void MainWindow::setupAdvancedTab(QTabWidget *tabWidget)
         onResizeModeChanged();
     });
     connect(m_threadCountSpin, QOverload<int>::of(&QSpinBox::valueChanged),
-            this, [this](int count) {
-        if (m_threadPool) m_threadPool->setMaxThreadCount(count);
-    });
+            this, &MainWindow::updatePoolSize);
+    connect(m_ioConcurrencySpin, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::updatePoolSize);
+}
+
+void MainWindow::updatePoolSize()
+{
+    // Limits of a running batch are fixed; the new values apply to the next one
+    if (!m_threadPool || m_batchActive) return;
+    m_threadPool->setMaxThreadCount(qMax(m_threadCountSpin->value(), m_ioConcurrencySpin->value()));
 }
 
 void MainWindow::syncSimpleToAdvanced()
@@ -614,70 +834,97 @@ void MainWindow::onAddFolder()
     QString dir = QFileDialog::getExistingDirectory(this, "Select Folder");
     if (dir.isEmpty()) return;
 
-    QStringList files;
-    QDirIterator it(dir, IMAGE_FILTERS, QDir::Files, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        files << it.next();
+    // Files stream in through addImageFiles as directories are listed
+    holdTableSourceOpen();
+    m_walker->walk(dir);
+    m_cancelBtn->setEnabled(true);
+}
+
+void MainWindow::onWalkProgress(int directoriesScanned, int filesFound)
+{
+    if (m_batchActive) return;
+    m_statusLabel->setText(QString("Scanning folders... %1 folder(s), %2 image(s) found")
+                           .arg(directoriesScanned).arg(filesFound));
+}
+
+void MainWindow::onWalkFinished(bool cancelled)
+{
+    if (!m_batchActive) {
+        m_cancelBtn->setEnabled(false);
+        if (cancelled)
+            m_statusLabel->setText(QString("Folder scan cancelled (%1 file(s) loaded)")
+                                   .arg(m_inputModel->rowCount()));
     }
-    addImageFiles(files);
+    closeTableSourceIfIdle();
 }
 
 void MainWindow::addImageFiles(const QStringList &paths)
 {
+    // Avoid duplicates (the set also covers paths that are still being scanned)
+    QStringList newPaths;
     for (const QString &path : paths) {
-        // Avoid duplicates
-        bool exists = false;
-        for (int r = 0; r < m_inputTable->rowCount(); ++r) {
-            if (m_inputTable->item(r, 0)->data(Qt::UserRole).toString() == path) {
-                exists = true;
-                break;
-            }
-        }
-        if (exists) continue;
-
-        QFileInfo info(path);
-        QImageReader reader(path);
-        QSize imgSize = reader.size();
-
-        int row = m_inputTable->rowCount();
-        m_inputTable->insertRow(row);
+        if (m_inputPaths.contains(path)) continue;
+        m_inputPaths.insert(path);
+        newPaths << path;
+    }
+    if (newPaths.isEmpty()) return;
 
-        auto *nameItem = new QTableWidgetItem(info.fileName());
-        nameItem->setData(Qt::UserRole, path);
-        m_inputTable->setItem(row, 0, nameItem);
+    // Sizes and dimensions are probed in the background; rows arrive in batches
+    holdTableSourceOpen();
+    m_scanner->scan(newPaths);
+    m_statusLabel->setText(QString("Scanning %1 file(s)...").arg(newPaths.size()));
+}
 
-        QString sizeStr;
-        qint64 sz = info.size();
-        if (sz >= 1024 * 1024)
-            sizeStr = QString::number(sz / (1024.0 * 1024.0), 'f', 2) + " MB";
+void MainWindow::onFilesScanned(const QList<InputFileInfo> &files)
+{
+    int firstRow = m_inputModel->rowCount();
+    m_inputModel->appendFiles(files);
+
+    if (m_tableSource && m_batchTakesNewRows) {
+        // A running table batch picks up the new rows as workers free up,
+        // unless it has already run dry; Process picks those up afterwards
+        if (m_tableSource->append(files, consecutiveRows(firstRow, files.size())))
+            m_journal.noteQueued(pathsOf(files));
         else
-            sizeStr = QString::number(sz / 1024.0, 'f', 1) + " KB";
-        m_inputTable->setItem(row, 1, new QTableWidgetItem(sizeStr));
-
-        QString dimStr = imgSize.isValid() ? QString("%1 x %2").arg(imgSize.width()).arg(imgSize.height()) : "?";
-        m_inputTable->setItem(row, 2, new QTableWidgetItem(dimStr));
+            m_batchTakesNewRows = false;
+    } else if (!m_batchActive && !m_walker->isRunning()) {
+        m_statusLabel->setText(QString("%1 file(s) loaded").arg(m_inputModel->rowCount()));
     }
+}
 
-    m_statusLabel->setText(QString("%1 file(s) loaded").arg(m_inputTable->rowCount()));
+void MainWindow::holdTableSourceOpen()
+{
+    // Keeps idle workers of a whole-table batch waiting for the rows on their way
+    if (m_tableSource && m_batchTakesNewRows && !m_tableSource->reopen())
+        m_batchTakesNewRows = false;
+}
+
+void MainWindow::closeTableSourceIfIdle()
+{
+    // Once no scan can add more rows, idle workers may stop waiting
+    if (m_tableSource && !m_walker->isRunning() && !m_scanner->isRunning())
+        m_tableSource->close();
 }
 
 void MainWindow::onRemoveSelected()
 {
-    auto ranges = m_inputTable->selectedRanges();
     QList<int> rows;
-    for (const auto &range : ranges) {
-        for (int r = range.topRow(); r <= range.bottomRow(); ++r)
-            rows << r;
+    const QModelIndexList selected = m_inputTable->selectionModel()->selectedRows();
+    rows.reserve(selected.size());
+    for (const QModelIndex &index : selected) {
+        rows << index.row();
+        m_inputPaths.remove(m_inputModel->path(index.row()));
     }
-    std::sort(rows.begin(), rows.end(), std::greater<int>());
-    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
-    for (int r : rows)
-        m_inputTable->removeRow(r);
+    m_inputModel->removeRowList(rows);
 }
 
 void MainWindow::onClearAll()
 {
-    m_inputTable->setRowCount(0);
+    m_scanner->cancel();
+    m_thumbnails->cancelPending();
+    m_previewPanel->setImage(QString());
+    m_inputPaths.clear();
+    m_inputModel->clear();
     m_statusLabel->setText("Ready");
 }
 
@@ -688,204 +935,354 @@ void MainWindow::onBrowseOutput()
         m_outputDirEdit->setText(dir);
 }
 
-void MainWindow::onProcess()
+std::shared_ptr<ProcessingSettings> MainWindow::settingsFromControls() const
 {
-    if (m_watcher) return;
+    // Reads the canonical (Advanced) controls
+    int fmtId = m_fmtGroup->checkedId();
+    int modeId = m_modeGroup->checkedId();
+    if (fmtId < 0 || modeId < 0) return nullptr;
+
+    auto settings = std::make_shared<ProcessingSettings>();
+    settings->format = static_cast<OutputFormat>(fmtId);
+    settings->resizeMode = static_cast<ResizeMode>(modeId);
+    settings->resizePercent = m_resizeSlider->value();
+    settings->resizeWidth = m_widthSpin->value();
+    settings->resizeHeight = m_heightSpin->value();
+    settings->quality = m_qualitySlider->value();
+    settings->useTargetSize = m_targetSizeCheck->isChecked();
+    settings->targetSizeKB = m_targetSizeSpin->value();
+    settings->jpegSubsampling = static_cast<JpegSubsampling>(m_jpegSubsamplingCombo->currentData().toInt());
+    settings->jpegOptimizeCoding = m_jpegOptimizeCheck->isChecked();
+    settings->jpegProgressive = m_jpegProgressiveCheck->isChecked();
+    settings->jpegFastDct = m_jpegFastDctCheck->isChecked();
+    settings->webpSpeed = static_cast<WebpSpeed>(m_webpSpeedCombo->currentData().toInt());
+    settings->avifSpeed = static_cast<AvifSpeed>(m_avifSpeedCombo->currentData().toInt());
+    settings->avifTimeBudgetMs = qRound(m_avifBudgetSpin->value() * 1000);
+    settings->passthrough = static_cast<Passthrough>(m_passthroughCombo->currentData().toInt());
+    settings->neverLarger = m_neverLargerCheck->isChecked();
+    return settings;
+}
 
-    // Ensure canonical (Advanced) state is current before building jobs
+std::shared_ptr<const ProcessingSettings> MainWindow::currentSettings()
+{
+    // Ensure canonical (Advanced) state is current before reading it
     if (m_tabWidget->currentIndex() == 0)
         syncSimpleToAdvanced();
 
-    if (m_inputTable->rowCount() == 0) {
+    // Captured once per batch and shared by every job
+    auto settings = settingsFromControls();
+    if (!settings)
+        QMessageBox::warning(this, "Error", "Please select an output format and resize mode.");
+    return settings;
+}
+
+void MainWindow::onProcess()
+{
+    if (m_batchActive) return;
+
+    // A folder scan that is still running keeps feeding the batch
+    bool moreInputsComing = m_walker->isRunning() || m_scanner->isRunning();
+    if (m_inputModel->rowCount() == 0 && !moreInputsComing) {
         QMessageBox::warning(this, "No Input", "Please add image files first.");
         return;
     }
-    QString outputDir = m_outputDirEdit->text();
-    m_usePerFileOutput = outputDir.isEmpty();
+    auto settings = currentSettings();
+    if (!settings || !settleInterruptedBatch()) return;
+
+    QList<InputFileInfo> inputs;
+    inputs.reserve(m_inputModel->rowCount());
+    for (int r = 0; r < m_inputModel->rowCount(); ++r)
+        inputs << m_inputModel->file(r);
+
+    auto source = std::make_shared<TableJobSource>(inputs, consecutiveRows(0, inputs.size()));
+    if (!moreInputsComing)
+        source->close();
+    m_tableSource = source;
+    m_batchTakesNewRows = true;
+    startBatch(source, settings, m_outputDirEdit->text());
+    if (m_batchActive)
+        m_journal.noteQueued(pathsOf(inputs));
+    else
+        m_tableSource.reset();
+}
+
+void MainWindow::onProcessNow()
+{
+    QList<int> rows;
+    const QModelIndexList selected = m_inputTable->selectionModel()->selectedRows();
+    for (const QModelIndex &index : selected)
+        rows << index.row();
+    if (rows.isEmpty()) return;
+    std::sort(rows.begin(), rows.end());
+
+    if (!m_batchActive) {
+        // Nothing running: the selection becomes a batch of its own
+        auto settings = currentSettings();
+        if (!settings || !settleInterruptedBatch()) return;
+        QList<InputFileInfo> inputs;
+        for (int row : rows)
+            inputs << m_inputModel->file(row);
+        auto source = std::make_shared<TableJobSource>(inputs, rows);
+        source->close();
+        m_tableSource = source;
+        m_batchTakesNewRows = false;
+        m_submittedRows = QSet<int>(rows.begin(), rows.end());
+        startBatch(source, settings, m_outputDirEdit->text());
+        if (m_batchActive)
+            m_journal.noteQueued(pathsOf(inputs));
+        else
+            m_tableSource.reset();
+        return;
+    }
+
+    if (!m_tableSource) {
+        m_statusLabel->setText("Files from the list cannot join a manifest batch");
+        return;
+    }
 
-    if (!m_usePerFileOutput) {
-        if (!QDir().mkpath(outputDir)) {
-            QMessageBox::warning(this, "Error", "Could not create output directory: " + outputDir);
+    // Rows a selection batch was not given join it first
+    if (!m_batchTakesNewRows) {
+        QList<InputFileInfo> extra;
+        QList<int> extraRows;
+        for (int row : rows) {
+            if (m_submittedRows.contains(row)) continue;
+            extra << m_inputModel->file(row);
+            extraRows << row;
+        }
+        if (!m_tableSource->append(extra, extraRows)) {
+            m_statusLabel->setText("The batch is finishing; process the remaining files afterwards");
             return;
         }
+        m_journal.noteQueued(pathsOf(extra));
+        for (int row : extraRows)
+            m_submittedRows.insert(row);
     }
 
-    // Validate UI selections
-    int fmtId = m_fmtGroup->checkedId();
-    int modeId = m_modeGroup->checkedId();
-    if (fmtId < 0 || modeId < 0) {
-        QMessageBox::warning(this, "Error", "Please select an output format and resize mode.");
+    int queued = m_scheduler->prioritize(QList<qint64>(rows.begin(), rows.end()));
+    m_statusLabel->setText(queued > 0 ? QString("Processing %1 selected file(s) next").arg(queued)
+                                      : QString("The selected files are already processed or in progress"));
+}
+
+void MainWindow::onProcessManifest()
+{
+    if (m_batchActive) return;
+
+    QString manifestPath = QFileDialog::getOpenFileName(
+        this, "Select Manifest", QString(),
+        "Manifests (*.txt *.lst *.jsonl *.ndjson);;All Files (*)");
+    if (manifestPath.isEmpty()) return;
+
+    auto settings = currentSettings();
+    if (!settings || !settleInterruptedBatch()) return;
+
+    auto source = std::make_shared<ManifestJobSource>(manifestPath, settings);
+    QString error;
+    if (!source->open(&error)) {
+        QMessageBox::warning(this, "Error", "Could not open manifest: " + error);
         return;
     }
-    OutputFormat fmt = static_cast<OutputFormat>(fmtId);
-    ResizeMode mode = static_cast<ResizeMode>(modeId);
-    QString ext = ImageProcessor::formatExtension(fmt);
-
-    // Build jobs with pre-computed output paths (avoids race conditions in concurrent processing)
-    QSet<QString> assignedPaths;
-    QList<ProcessingJob> jobs;
-    for (int r = 0; r < m_inputTable->rowCount(); ++r) {
-        ProcessingJob job;
-        job.inputPath = m_inputTable->item(r, 0)->data(Qt::UserRole).toString();
-        job.outputDir = m_usePerFileOutput
-            ? QFileInfo(job.inputPath).dir().filePath("resized")
-            : outputDir;
-        if (m_usePerFileOutput) {
-            if (!QDir().mkpath(job.outputDir)) {
-                QMessageBox::warning(this, "Error", "Could not create output directory: " + job.outputDir);
-                return;
-            }
+    startBatch(source, settings, m_outputDirEdit->text(), manifestPath);
+}
+
+void MainWindow::onResumeBatch()
+{
+    if (m_batchActive) return;
+
+    const QString journalPath = BatchJournal::defaultPath();
+    BatchJournal::State state;
+    if (!BatchJournal::load(journalPath, state)) {
+        QFile::remove(journalPath);
+        m_resumeAction->setEnabled(false);
+        QMessageBox::information(this, "Resume", "There is no interrupted batch to resume.");
+        return;
+    }
+
+    std::shared_ptr<JobSource> inner;
+    if (!state.manifestPath.isEmpty()) {
+        auto manifest = std::make_shared<ManifestJobSource>(state.manifestPath, state.settings);
+        QString error;
+        if (!manifest->open(&error)) {
+            QMessageBox::warning(this, "Error", "Could not open manifest: " + error);
+            return;
         }
-        job.outputPath = ImageProcessor::buildOutputPath(job.inputPath, job.outputDir, ext);
-        // Deduplicate against already-assigned paths in this batch (handles same-named files from different dirs)
-        if (assignedPaths.contains(job.outputPath)) {
-            QFileInfo outInfo(job.outputPath);
-            QString baseName = outInfo.completeBaseName();
-            int counter = 1;
-            QString candidate;
-            do {
-                candidate = QDir(job.outputDir).filePath(baseName + QString("_%1").arg(counter) + ext);
-                ++counter;
-            } while (assignedPaths.contains(candidate) || QFile::exists(candidate));
-            job.outputPath = candidate;
+        inner = manifest;
+    } else {
+        // The table may be empty after a restart; the journal has the inputs
+        QList<InputFileInfo> inputs;
+        inputs.reserve(state.queued.size());
+        for (const QString &path : std::as_const(state.queued)) {
+            InputFileInfo info;
+            info.path = path;
+            info.size = -1;  // Looked up when scheduled
+            inputs << info;
         }
-        assignedPaths.insert(job.outputPath);
-        job.format = fmt;
-        job.resizeMode = mode;
-        job.resizePercent = m_resizeSlider->value();
-        job.resizeWidth = m_widthSpin->value();
-        job.resizeHeight = m_heightSpin->value();
-        job.quality = m_qualitySlider->value();
-        job.useTargetSize = m_targetSizeCheck->isChecked();
-        job.targetSizeKB = m_targetSizeSpin->value();
-        job.cancelFlag = &m_cancelled;
-        jobs << job;
+        auto table = std::make_shared<TableJobSource>(inputs, consecutiveRows(0, inputs.size()));
+        table->close();
+        inner = table;
     }
+    auto source = std::make_shared<ResumeJobSource>(inner, state.finished, state.settings);
+    startBatch(source, state.settings, state.outputDir, state.manifestPath, true);
+    if (m_batchActive)
+        m_statusLabel->setText(QString("Resuming; %1 file(s) finished earlier are skipped")
+                               .arg(state.finished.size()));
+}
 
-    // Pre-populate results table with placeholders matching input order
-    m_resultsTable->setRowCount(jobs.size());
-    for (int r = 0; r < jobs.size(); ++r) {
-        QFileInfo info(jobs[r].inputPath);
-        m_resultsTable->setItem(r, 0, new QTableWidgetItem(info.fileName()));
-        m_resultsTable->setItem(r, 1, new QTableWidgetItem("..."));
-        m_resultsTable->setItem(r, 2, new QTableWidgetItem("..."));
-        m_resultsTable->setItem(r, 3, new QTableWidgetItem("..."));
-        m_resultsTable->setItem(r, 4, new QTableWidgetItem("Processing..."));
+bool MainWindow::settleInterruptedBatch()
+{
+    const QString journalPath = BatchJournal::defaultPath();
+    BatchJournal::State state;
+    if (!QFile::exists(journalPath) || !BatchJournal::load(journalPath, state)) return true;
+
+    QMessageBox box(QMessageBox::Question, "Interrupted Batch",
+                    "The last batch was closed or crashed before it finished. Starting a new batch "
+                    "discards its record, so it can no longer be resumed.", QMessageBox::NoButton, this);
+    QPushButton *resumeBtn = box.addButton("Resume It", QMessageBox::AcceptRole);
+    QPushButton *discardBtn = box.addButton("Discard and Start New", QMessageBox::DestructiveRole);
+    box.addButton(QMessageBox::Cancel);
+    box.setDefaultButton(resumeBtn);
+    box.exec();
+
+    if (box.clickedButton() == discardBtn) return true;
+    if (box.clickedButton() == resumeBtn) onResumeBatch();
+    return false;
+}
+
+void MainWindow::startBatch(std::shared_ptr<JobSource> source,
+                            std::shared_ptr<const ProcessingSettings> settings,
+                            const QString &outputDir, const QString &manifestPath, bool resume)
+{
+    m_usePerFileOutput = outputDir.isEmpty();
+    if (!m_usePerFileOutput && !QDir().mkpath(outputDir)) {
+        QMessageBox::warning(this, "Error", "Could not create output directory: " + outputDir);
+        return;
     }
-    m_progressBar->setMaximum(jobs.size());
-    m_progressBar->setValue(0);
+
+    m_source = source;
+    m_batchActive = true;
     m_cancelled = false;
+    m_cancelClock.invalidate();
+
+    m_resultsModel->clear();
+    auto reportFormat = static_cast<ReportWriter::Format>(m_reportFormatCombo->currentData().toInt());
+    if (reportFormat != ReportWriter::Format::None) {
+        // Without an output folder the report goes next to the first output
+        m_reportWriter = std::make_unique<ReportWriter>(reportFormat, outputDir);
+        m_dispatcher.addSink(m_reportWriter.get());
+    }
+    bool journaled = resume ? m_journal.reopen(BatchJournal::defaultPath())
+                            : m_journal.create(BatchJournal::defaultPath(), *settings, outputDir, manifestPath);
+    if (journaled)
+        m_dispatcher.addSink(&m_journal);
+    m_dispatcher.begin();
+
+    m_progressBar->setMaximum(0);
+    m_progressBar->setValue(0);
+    m_uiUpdateTimer->start();
     m_processBtn->setEnabled(false);
+    m_processManifestAction->setEnabled(false);
+    m_resumeAction->setEnabled(false);
     m_cancelBtn->setEnabled(true);
+    m_removeSelectedBtn->setEnabled(false);
+    m_clearAllBtn->setEnabled(false);
     m_statusLabel->setText("Processing...");
 
-    m_watcher = new QFutureWatcher<ProcessingResult>(this);
-    connect(m_watcher, &QFutureWatcher<ProcessingResult>::resultReadyAt, this, [this](int index) {
-        ProcessingResult result = m_watcher->resultAt(index);
-        m_progressBar->setValue(m_progressBar->value() + 1);
-
-        // Update the pre-populated row in-place (preserves input order)
-        int row = index;
+    // Workers start pulling immediately; nothing is listed or planned up front
+    m_scheduler->start(source, settings, outputDir, &m_dispatcher,
+                       m_ioConcurrencySpin->value(), m_threadCountSpin->value(),
+                       m_isolatedWorkersCheck->isChecked());
+}
 
-        auto formatSize = [](qint64 sz) -> QString {
-            if (sz >= 1024 * 1024)
-                return QString::number(sz / (1024.0 * 1024.0), 'f', 2) + " MB";
-            return QString::number(sz / 1024.0, 'f', 1) + " KB";
-        };
+void MainWindow::onCancel()
+{
+    m_walker->cancel();
+    if (!m_batchActive) {
+        m_statusLabel->setText("Cancelling folder scan...");
+        return;
+    }
 
-        m_resultsTable->setItem(row, 1, new QTableWidgetItem(formatSize(result.originalSize)));
-        m_resultsTable->setItem(row, 2, new QTableWidgetItem(formatSize(result.newSize)));
-
-        if (result.status == ResultStatus::Success) {
-            double pct = result.reductionPercent();
-            auto *pctItem = new QTableWidgetItem(QString::number(pct, 'f', 1) + "%");
-            if (pct > 50)
-                pctItem->setForeground(QColor(0, 150, 0));
-            else if (pct > 20)
-                pctItem->setForeground(QColor(0, 100, 200));
-            else if (pct < 0)
-                pctItem->setForeground(QColor(200, 0, 0));
-            m_resultsTable->setItem(row, 3, pctItem);
-            QString statusText = "OK";
-            if (!result.errorMessage.isEmpty())
-                statusText += " (" + result.errorMessage + ")";
-            m_resultsTable->setItem(row, 4, new QTableWidgetItem(statusText));
-        } else if (result.status == ResultStatus::Cancelled) {
-            m_resultsTable->setItem(row, 3, new QTableWidgetItem("-"));
-            auto *statusItem = new QTableWidgetItem("Cancelled");
-            statusItem->setForeground(QColor(150, 150, 150));
-            m_resultsTable->setItem(row, 4, statusItem);
-        } else {
-            m_resultsTable->setItem(row, 3, new QTableWidgetItem("-"));
-            auto *statusItem = new QTableWidgetItem(result.errorMessage);
-            statusItem->setForeground(Qt::red);
-            m_resultsTable->setItem(row, 4, statusItem);
-        }
-    });
-    connect(m_watcher, &QFutureWatcher<ProcessingResult>::finished,
-            this, &MainWindow::onProcessingFinished);
+    if (!m_cancelled) m_cancelClock.start();
+    m_cancelled = true;
+    m_statusLabel->setText("Cancelling...");
+    m_scheduler->cancel();
+}
 
-    m_threadPool->setMaxThreadCount(m_threadCountSpin->value());
-    QFuture<ProcessingResult> future = QtConcurrent::mapped(m_threadPool, jobs, ImageProcessor::process);
-    m_watcher->setFuture(future);
+void MainWindow::onProcessingFinished(bool cancelled)
+{
+    if (!m_batchActive) return;  // Already finished by closeEvent
+    m_cancelled = m_cancelled || cancelled;
+    finishBatch();
 }
 
-void MainWindow::onCancel()
+void MainWindow::flushUiUpdates()
 {
-    if (m_watcher) {
-        m_cancelled = true;
-        m_watcher->cancel();
-        m_statusLabel->setText("Cancelling...");
+    m_dispatcher.drain();
+    int completed = m_stats.completed();
+    if (m_source) {
+        qint64 total = qMax<qint64>(m_source->estimatedTotal(), completed);
+        m_progressBar->setMaximum(static_cast<int>(qMin<qint64>(total, std::numeric_limits<int>::max())));
     }
+    m_progressBar->setValue(completed);
 }
 
-void MainWindow::onProcessingFinished()
+void MainWindow::finishBatch()
 {
+    m_uiUpdateTimer->stop();
+    flushUiUpdates();
+    m_batchActive = false;
+    m_source.reset();
+    m_tableSource.reset();
+    m_batchTakesNewRows = false;
+    m_submittedRows.clear();
     m_processBtn->setEnabled(true);
-    m_cancelBtn->setEnabled(false);
+    m_processManifestAction->setEnabled(true);
+    m_cancelBtn->setEnabled(m_walker->isRunning());
+    m_removeSelectedBtn->setEnabled(true);
+    m_clearAllBtn->setEnabled(true);
+    int total = m_stats.completed();
+    m_progressBar->setMaximum(qMax(1, total));
+    m_progressBar->setValue(total);
+
+    m_dispatcher.finish(m_cancelled);
+    QString reportNote;
+    if (m_reportWriter) {
+        if (m_reportWriter->failed())
+            reportNote = " - report could not be written: " + QDir::toNativeSeparators(m_reportWriter->filePath());
+        m_dispatcher.removeSink(m_reportWriter.get());
+        m_reportWriter.reset();
+    }
+    m_dispatcher.removeSink(&m_journal);
+    // The journal outlives a cancelled or interrupted batch only
+    m_resumeAction->setEnabled(QFile::exists(BatchJournal::defaultPath()));
+
     if (m_cancelled) {
-        // Sweep stale "Processing..." rows that never got a result
-        int completedCount = 0;
-        for (int r = 0; r < m_resultsTable->rowCount(); ++r) {
-            auto *statusItem = m_resultsTable->item(r, 4);
-            if (statusItem && statusItem->text() == "Processing...") {
-                m_resultsTable->setItem(r, 1, new QTableWidgetItem("-"));
-                m_resultsTable->setItem(r, 2, new QTableWidgetItem("-"));
-                m_resultsTable->setItem(r, 3, new QTableWidgetItem("-"));
-                auto *cancelledItem = new QTableWidgetItem("Cancelled");
-                cancelledItem->setForeground(QColor(150, 150, 150));
-                m_resultsTable->setItem(r, 4, cancelledItem);
-            } else if (statusItem && statusItem->text().startsWith("OK")) {
-                ++completedCount;
-            }
-        }
-        m_statusLabel->setText(QString("Cancelled (%1 of %2 completed)")
-                               .arg(completedCount).arg(m_resultsTable->rowCount()));
+        // Files that were never started do not appear in the results
+        // Cancel-to-idle latency: how long in-flight decodes and encodes took to stop
+        QString stopNote = m_cancelClock.isValid()
+            ? QString(", stopped in %1 ms").arg(m_cancelClock.elapsed()) : QString();
+        m_statusLabel->setText(QString("Cancelled (%1 of %2 completed%3)")
+                               .arg(m_stats.succeeded()).arg(total).arg(stopNote) + reportNote);
     } else if (m_usePerFileOutput) {
         m_statusLabel->setText(QString("Done - %1 file(s) saved to \"resized\" subfolders next to originals")
-                              .arg(m_resultsTable->rowCount()));
+                              .arg(total) + reportNote);
     } else {
-        m_statusLabel->setText(QString("Done - %1 file(s) processed").arg(m_resultsTable->rowCount()));
+        m_statusLabel->setText(QString("Done - %1 file(s) processed").arg(total) + reportNote);
     }
-    m_watcher->deleteLater();
-    m_watcher = nullptr;
 }
 
 void MainWindow::onCopyResults()
 {
     QString tsv;
     // Header
-    for (int c = 0; c < m_resultsTable->columnCount(); ++c) {
+    for (int c = 0; c < m_resultsModel->columnCount(); ++c) {
         if (c > 0) tsv += '\t';
-        tsv += m_resultsTable->horizontalHeaderItem(c)->text();
+        tsv += m_resultsModel->headerData(c, Qt::Horizontal).toString();
     }
     tsv += '\n';
     // Rows
-    for (int r = 0; r < m_resultsTable->rowCount(); ++r) {
-        for (int c = 0; c < m_resultsTable->columnCount(); ++c) {
+    for (int r = 0; r < m_resultsModel->rowCount(); ++r) {
+        for (int c = 0; c < m_resultsModel->columnCount(); ++c) {
             if (c > 0) tsv += '\t';
-            auto *item = m_resultsTable->item(r, c);
-            tsv += item ? item->text() : "";
+            tsv += m_resultsModel->text(r, c);
         }
         tsv += '\n';
     }
@@ -901,8 +1298,8 @@ void MainWindow::onOpenOutputFolder()
 
     if (dir.isEmpty()) {
         // No explicit output dir — open the folder of the first input file
-        if (m_inputTable->rowCount() > 0) {
-            QString firstInput = m_inputTable->item(0, 0)->data(Qt::UserRole).toString();
+        if (m_inputModel->rowCount() > 0) {
+            QString firstInput = m_inputModel->path(0);
             dir = QFileInfo(firstInput).absolutePath();
         } else {
             m_statusLabel->setText("No output folder set and no input files added.");
@@ -1029,6 +1426,10 @@ void MainWindow::onFormatChanged(int formatId)
 
     // Info label
     m_pngInfoLabel->setVisible(isPng);
+    bool isAuto = (formatId == 4); // OutputFormat::Auto, which may use any of them
+    m_jpegOptions->setVisible(formatId == 0 || isAuto); // OutputFormat::JPEG
+    m_webpOptions->setVisible(formatId == 2 || isAuto); // OutputFormat::WebP
+    m_avifOptions->setVisible(formatId == 3 || isAuto); // OutputFormat::AVIF
 }
 
 void MainWindow::updateResizeControls()
@@ -1064,9 +1465,9 @@ void MainWindow::dropEvent(QDropEvent *event)
         QString path = url.toLocalFile();
         QFileInfo info(path);
         if (info.isDir()) {
-            QDirIterator it(path, IMAGE_FILTERS, QDir::Files, QDirIterator::Subdirectories);
-            while (it.hasNext())
-                paths << it.next();
+            holdTableSourceOpen();
+            m_walker->walk(path);
+            m_cancelBtn->setEnabled(true);
         } else if (info.isFile()) {
             QString ext = info.suffix().toLower();
             if (BARE_EXTENSIONS.contains(ext))
@@ -1078,12 +1479,14 @@ void MainWindow::dropEvent(QDropEvent *event)
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
-    if (m_watcher && m_watcher->isRunning()) {
+    m_walker->cancel();
+    if (m_batchActive) {
+        // Also stops a batch whose workers are waiting for scanned files
         m_cancelled = true;
-        m_watcher->disconnect();
-        m_watcher->cancel();
+        m_scheduler->cancel();
         m_statusLabel->setText("Cancelling...");
-        m_watcher->waitForFinished();
+        m_scheduler->waitForDone();
+        finishBatch();  // Hands the last results to the sinks and closes the report
     }
     saveSettings();
     event->accept();
@@ -1106,9 +1509,26 @@ void MainWindow::loadSettings()
     m_qualitySlider->setValue(s.quality());
     m_targetSizeCheck->setChecked(s.useTargetSize());
     m_targetSizeSpin->setValue(static_cast<int>(s.targetSizeKB()));
+    int subsamplingIndex = m_jpegSubsamplingCombo->findData(static_cast<int>(s.jpegSubsampling()));
+    m_jpegSubsamplingCombo->setCurrentIndex(qMax(0, subsamplingIndex));
+    m_jpegOptimizeCheck->setChecked(s.jpegOptimizeCoding());
+    m_jpegProgressiveCheck->setChecked(s.jpegProgressive());
+    m_jpegFastDctCheck->setChecked(s.jpegFastDct());
+    int webpIndex = m_webpSpeedCombo->findData(static_cast<int>(s.webpSpeed()));
+    m_webpSpeedCombo->setCurrentIndex(webpIndex >= 0 ? webpIndex : 1);
+    int avifIndex = m_avifSpeedCombo->findData(static_cast<int>(s.avifSpeed()));
+    m_avifSpeedCombo->setCurrentIndex(avifIndex >= 0 ? avifIndex : 1);
+    m_avifBudgetSpin->setValue(s.avifTimeBudgetMs() / 1000.0);
 
     m_threadCountSpin->setValue(s.threadCount());
-    m_threadPool->setMaxThreadCount(s.threadCount());
+    m_ioConcurrencySpin->setValue(s.ioConcurrency());
+    int reportIndex = m_reportFormatCombo->findData(s.reportFormat());
+    m_reportFormatCombo->setCurrentIndex(qMax(0, reportIndex));
+    int passthroughIndex = m_passthroughCombo->findData(static_cast<int>(s.passthrough()));
+    m_passthroughCombo->setCurrentIndex(qMax(0, passthroughIndex));
+    m_neverLargerCheck->setChecked(s.neverLarger());
+    m_isolatedWorkersCheck->setChecked(s.isolatedWorkers());
+    updatePoolSize();
     m_tabWidget->setCurrentIndex(s.lastActiveTab());
 
     updateResizeControls();
@@ -1132,6 +1552,18 @@ void MainWindow::saveSettings()
     s.setQuality(m_qualitySlider->value());
     s.setUseTargetSize(m_targetSizeCheck->isChecked());
     s.setTargetSizeKB(m_targetSizeSpin->value());
+    s.setJpegSubsampling(static_cast<JpegSubsampling>(m_jpegSubsamplingCombo->currentData().toInt()));
+    s.setJpegOptimizeCoding(m_jpegOptimizeCheck->isChecked());
+    s.setJpegProgressive(m_jpegProgressiveCheck->isChecked());
+    s.setJpegFastDct(m_jpegFastDctCheck->isChecked());
+    s.setWebpSpeed(static_cast<WebpSpeed>(m_webpSpeedCombo->currentData().toInt()));
+    s.setAvifSpeed(static_cast<AvifSpeed>(m_avifSpeedCombo->currentData().toInt()));
+    s.setAvifTimeBudgetMs(qRound(m_avifBudgetSpin->value() * 1000));
     s.setThreadCount(m_threadCountSpin->value());
+    s.setIoConcurrency(m_ioConcurrencySpin->value());
+    s.setReportFormat(m_reportFormatCombo->currentData().toInt());
+    s.setPassthrough(static_cast<Passthrough>(m_passthroughCombo->currentData().toInt()));
+    s.setNeverLarger(m_neverLargerCheck->isChecked());
+    s.setIsolatedWorkers(m_isolatedWorkersCheck->isChecked());
     s.setLastActiveTab(m_tabWidget->currentIndex());
 }
@@ -3,19 +3,21 @@
 
 #pragma once
 
-#include <atomic>
+#include <memory>
 
 #include <QMainWindow>
-#include <QTableWidget>
+#include <QTableView>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QProgressBar>
 #include <QLabel>
 #include <QPushButton>
 #include <QRadioButton>
 #include <QSlider>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QCheckBox>
 #include <QLineEdit>
-#include <QFutureWatcher>
 #include <QSplitter>
 #include <QButtonGroup>
 #include <QPointer>
@@ -23,11 +25,25 @@
 #include <QComboBox>
 #include <QThreadPool>
 #include <QThread>
+#include <QSet>
 
 #include "ProcessingJob.h"
 #include "ProcessingResult.h"
-
+#include "InputScanner.h"
+#include "InputFileModel.h"
+#include "ResultsModel.h"
+#include "ResultDispatcher.h"
+#include "BatchStats.h"
+#include "BatchJournal.h"
+
+class BatchScheduler;
+class DirectoryWalker;
 class FormatGuideDialog;
+class JobSource;
+class PreviewPanel;
+class ReportWriter;
+class TableJobSource;
+class ThumbnailCache;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -48,8 +64,11 @@ private slots:
     void onClearAll();
     void onBrowseOutput();
     void onProcess();
+    void onProcessManifest();
+    void onProcessNow();
+    void onResumeBatch();
     void onCancel();
-    void onProcessingFinished();
+    void onProcessingFinished(bool cancelled);
     void onCopyResults();
     void onOpenOutputFolder();
     void onAbout();
@@ -58,6 +77,9 @@ private slots:
     void onTargetSizeToggled(bool checked);
     void onFormatChanged(int formatId);
     void onFormatGuide();
+    void onFilesScanned(const QList<InputFileInfo> &files);
+    void onWalkProgress(int directoriesScanned, int filesFound);
+    void onWalkFinished(bool cancelled);
 
 private:
     void setupMenuBar();
@@ -70,6 +92,21 @@ private:
     void loadSettings();
     void saveSettings();
     void updateResizeControls();
+    void updatePoolSize();
+    std::shared_ptr<ProcessingSettings> settingsFromControls() const;
+    std::shared_ptr<const ProcessingSettings> currentSettings();
+    void updatePreviewSettings();
+    // Before a new batch replaces the journal of an interrupted one, asks
+    // whether to resume it instead. True if the new batch may start.
+    bool settleInterruptedBatch();
+    // manifestPath is recorded in the journal; resume continues the existing journal
+    void startBatch(std::shared_ptr<JobSource> source, std::shared_ptr<const ProcessingSettings> settings,
+                    const QString &outputDir, const QString &manifestPath = QString(), bool resume = false);
+    void holdTableSourceOpen();
+    void closeTableSourceIfIdle();
+    void finishBatch();
+    void flushUiUpdates();
+    static void configureTableView(QTableView *view);
 
     // Tab widget
     QTabWidget *m_tabWidget = nullptr;
@@ -85,11 +122,16 @@ private:
     QPushButton *m_simpleBrowseOutputBtn = nullptr;
 
     // Input panel
-    QTableWidget *m_inputTable = nullptr;
+    QTableView *m_inputTable = nullptr;
+    InputFileModel *m_inputModel = nullptr;
+    ThumbnailCache *m_thumbnails = nullptr;
     QPushButton *m_addFilesBtn = nullptr;
     QPushButton *m_addFolderBtn = nullptr;
     QPushButton *m_removeSelectedBtn = nullptr;
     QPushButton *m_clearAllBtn = nullptr;
+    QSet<QString> m_inputPaths;      // Every listed or still-scanning input, for O(1) duplicate checks
+    InputScanner *m_scanner = nullptr;
+    DirectoryWalker *m_walker = nullptr;
 
     // Output settings
     QLineEdit *m_outputDirEdit = nullptr;
@@ -98,6 +140,7 @@ private:
     QRadioButton *m_fmtPng = nullptr;
     QRadioButton *m_fmtWebp = nullptr;
     QRadioButton *m_fmtAvif = nullptr;
+    QRadioButton *m_fmtAuto = nullptr;
     QButtonGroup *m_fmtGroup = nullptr;
 
     // Processing options
@@ -117,9 +160,24 @@ private:
     QLabel *m_pngInfoLabel = nullptr;
     QCheckBox *m_targetSizeCheck = nullptr;
     QSpinBox *m_targetSizeSpin = nullptr;
+    QWidget *m_jpegOptions = nullptr;
+    QComboBox *m_jpegSubsamplingCombo = nullptr;
+    QCheckBox *m_jpegOptimizeCheck = nullptr;
+    QCheckBox *m_jpegProgressiveCheck = nullptr;
+    QCheckBox *m_jpegFastDctCheck = nullptr;
+    QWidget *m_webpOptions = nullptr;
+    QComboBox *m_webpSpeedCombo = nullptr;
+    QWidget *m_avifOptions = nullptr;
+    QComboBox *m_avifSpeedCombo = nullptr;
+    QDoubleSpinBox *m_avifBudgetSpin = nullptr;
 
     // Advanced tab - Performance
     QSpinBox    *m_threadCountSpin = nullptr;
+    QSpinBox    *m_ioConcurrencySpin = nullptr;
+    QComboBox   *m_reportFormatCombo = nullptr;
+    QComboBox   *m_passthroughCombo = nullptr;
+    QCheckBox   *m_neverLargerCheck = nullptr;
+    QCheckBox   *m_isolatedWorkersCheck = nullptr;
 
     // Dedicated thread pool
     QThreadPool *m_threadPool = nullptr;
@@ -131,15 +189,36 @@ private:
     QLabel *m_statusLabel = nullptr;
 
     // Results panel
-    QTableWidget *m_resultsTable = nullptr;
+    QTableView *m_resultsTable = nullptr;
+    ResultsModel *m_resultsModel = nullptr;
     QPushButton *m_copyResultsBtn = nullptr;
     QPushButton *m_openOutputBtn = nullptr;
+    PreviewPanel *m_previewPanel = nullptr;
+
+    QAction *m_processManifestAction = nullptr;
+    QAction *m_processNowAction = nullptr;
+    QAction *m_resumeAction = nullptr;
 
     // Format Guide
     QPointer<FormatGuideDialog> m_formatGuideDialog;
 
-    // Processing state
-    QFutureWatcher<ProcessingResult> *m_watcher = nullptr;
-    std::atomic<bool> m_cancelled{false};
+    // Processing state. Workers pull jobs from m_source; a batch started from
+    // the input table keeps taking rows added by folder scans until they finish.
+    BatchScheduler *m_scheduler = nullptr;
+    std::shared_ptr<JobSource> m_source;
+    std::shared_ptr<TableJobSource> m_tableSource;  // Same object as m_source for table batches
+    bool m_batchTakesNewRows = false;  // Whole-table batch: rows added while it runs join it
+    QSet<int> m_submittedRows;         // Rows given to a selection-only batch
+    bool m_cancelled = false;
     bool m_usePerFileOutput = false;
+    bool m_batchActive = false;
+    QElapsedTimer m_cancelClock;  // Started on Cancel, read when the last worker stops
+
+    // Workers push results into the dispatcher; the sinks (results model,
+    // stats, optional report) drain it on the UI update timer
+    ResultDispatcher m_dispatcher;
+    BatchStats m_stats;
+    BatchJournal m_journal;  // Lets a closed or crashed batch be resumed
+    std::unique_ptr<ReportWriter> m_reportWriter;
+    QTimer *m_uiUpdateTimer = nullptr;
 };
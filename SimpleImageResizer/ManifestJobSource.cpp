@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ManifestJobSource.h"
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+
+static bool parseFormat(const QString &name, OutputFormat &format)
+{
+    QString n = name.toLower();
+    if (n == "jpg" || n == "jpeg") format = OutputFormat::JPEG;
+    else if (n == "png")           format = OutputFormat::PNG;
+    else if (n == "webp")          format = OutputFormat::WebP;
+    else if (n == "avif")          format = OutputFormat::AVIF;
+    else if (n == "auto")          format = OutputFormat::Auto;
+    else return false;
+    return true;
+}
+
+// Applies the per-file keys of obj on top of settings. Returns false with
+// errorMessage set for values that cannot be used.
+static bool applyOverrides(const QJsonObject &obj, ProcessingSettings &settings, QString &errorMessage)
+{
+    if (obj.contains("format") && !parseFormat(obj.value("format").toString(), settings.format)) {
+        errorMessage = "unknown format \"" + obj.value("format").toString() + "\"";
+        return false;
+    }
+    if (obj.contains("quality"))
+        settings.quality = qBound(1, obj.value("quality").toInt(settings.quality), 100);
+
+    bool hasWidth = obj.contains("width");
+    bool hasHeight = obj.contains("height");
+    if (obj.value("noResize").toBool()) {
+        settings.resizeMode = ResizeMode::NoResize;
+    } else if (obj.contains("scale")) {
+        settings.resizeMode = ResizeMode::Percentage;
+        settings.resizePercent = qBound(1, obj.value("scale").toInt(100), 1000);
+    } else if (hasWidth || hasHeight) {
+        settings.resizeWidth = obj.value("width").toInt(settings.resizeWidth);
+        settings.resizeHeight = obj.value("height").toInt(settings.resizeHeight);
+        settings.resizeMode = (hasWidth && hasHeight) ? ResizeMode::FitBoundingBox
+                            : hasWidth ? ResizeMode::FitWidth : ResizeMode::FitHeight;
+    }
+
+    if (obj.contains("targetKB")) {
+        qint64 kb = obj.value("targetKB").toInteger();
+        settings.useTargetSize = kb > 0;
+        if (kb > 0) settings.targetSizeKB = kb;
+    }
+    return true;
+}
+
+ManifestJobSource::ManifestJobSource(const QString &manifestPath,
+                                     std::shared_ptr<const ProcessingSettings> defaults)
+    : m_file(manifestPath)
+    , m_baseDir(QFileInfo(manifestPath).absoluteDir())
+    , m_defaults(std::move(defaults))
+{
+}
+
+bool ManifestJobSource::open(QString *errorMessage)
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) *errorMessage = m_file.errorString();
+        return false;
+    }
+    m_fileSize = m_file.size();
+    return true;
+}
+
+void ManifestJobSource::parseLine(const QByteArray &line, JobEntry &entry)
+{
+    if (!line.startsWith('{')) {
+        entry.inputPath = QDir::cleanPath(m_baseDir.absoluteFilePath(QString::fromUtf8(line)));
+        return;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    QString inputPath = doc.object().value("input").toString();
+    if (parseError.error != QJsonParseError::NoError || inputPath.isEmpty()) {
+        entry.inputPath = QString::fromUtf8(line);
+        entry.error = QString("Manifest line %1: %2").arg(m_lineNumber)
+                      .arg(parseError.error != QJsonParseError::NoError ? parseError.errorString()
+                                                                        : QString("missing \"input\""));
+        return;
+    }
+
+    QJsonObject obj = doc.object();
+    entry.inputPath = QDir::cleanPath(m_baseDir.absoluteFilePath(inputPath));
+    if (obj.contains("outputDir"))
+        entry.outputDir = QDir::cleanPath(m_baseDir.absoluteFilePath(obj.value("outputDir").toString()));
+
+    // Only lines that override something get their own settings
+    if (obj.size() > (obj.contains("outputDir") ? 2 : 1)) {
+        auto settings = std::make_shared<ProcessingSettings>(*m_defaults);
+        QString error;
+        if (!applyOverrides(obj, *settings, error)) {
+            entry.error = QString("Manifest line %1: %2").arg(m_lineNumber).arg(error);
+            return;
+        }
+        entry.settings = std::move(settings);
+    }
+}
+
+JobSource::Status ManifestJobSource::next(JobEntry &entry)
+{
+    QMutexLocker lock(&m_mutex);
+    while (!m_done.load(std::memory_order_relaxed)) {
+        if (m_file.atEnd()) {
+            m_done = true;
+            m_file.close();
+            break;
+        }
+        QByteArray line = m_file.readLine().trimmed();
+        ++m_lineNumber;
+        m_bytesRead = m_file.pos();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        entry = JobEntry();
+        parseLine(line, entry);
+        ++m_entries;
+        return Status::Ready;
+    }
+    return Status::Exhausted;
+}
+
+void ManifestJobSource::cancel()
+{
+    m_done = true;
+}
+
+qint64 ManifestJobSource::estimatedTotal() const
+{
+    qint64 entries = m_entries.load(std::memory_order_relaxed);
+    qint64 bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+    if (m_done.load(std::memory_order_relaxed) || bytesRead <= 0 || bytesRead >= m_fileSize)
+        return entries;
+    // Extrapolate from the average line length seen so far
+    return entries * m_fileSize / bytesRead;
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+
+#include "JobSource.h"
+
+// Job source reading a manifest file line by line as workers ask for work,
+// so even multi-million-line manifests start immediately and use constant
+// memory. Each line is either
+//   - an image path, or
+//   - a JSON object: {"input": "a.jpg", "outputDir": "...", "format": "webp",
+//     "quality": 80, "scale": 50, "width": 1920, "height": 1080,
+//     "noResize": true, "targetKB": 300}
+//     where every key except "input" overrides the batch setting for that file.
+// Relative paths are resolved against the manifest's folder. Blank lines and
+// lines starting with '#' are skipped.
+class ManifestJobSource : public JobSource {
+public:
+    ManifestJobSource(const QString &manifestPath, std::shared_ptr<const ProcessingSettings> defaults);
+
+    bool open(QString *errorMessage);
+
+    Status next(JobEntry &entry) override;
+    void cancel() override;
+    qint64 estimatedTotal() const override;
+
+private:
+    void parseLine(const QByteArray &line, JobEntry &entry);
+
+    QMutex m_mutex;
+    QFile m_file;
+    QDir m_baseDir;
+    std::shared_ptr<const ProcessingSettings> m_defaults;
+    qint64 m_lineNumber = 0;
+    qint64 m_fileSize = 0;
+    std::atomic<qint64> m_entries{0};
+    std::atomic<qint64> m_bytesRead{0};
+    std::atomic<bool> m_done{false};
+};
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer / single-consumer queue (Vyukov's
+// intrusive design). push() may be called from any thread and never blocks;
+// tryPop() must only be called from one consumer thread at a time. A value
+// is freed as soon as it has been popped.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : m_head(&m_stub), m_tail(&m_stub) {}
+
+    ~MpscQueue()
+    {
+        T discarded;
+        while (tryPop(discarded)) {}
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value)
+    {
+        Node *node = new Node;
+        node->value = std::move(value);
+        enqueue(node);
+    }
+
+    // Returns false if the queue is empty or a producer is midway through a
+    // push; in the latter case the value is returned by a later call.
+    bool tryPop(T &out)
+    {
+        Node *tail = m_tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &m_stub) {
+            if (!next) return false;
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            m_tail = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        if (tail != m_head.load(std::memory_order_acquire)) return false;
+
+        // tail is the last node: park the stub behind it so it can be unlinked
+        enqueue(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            m_tail = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        T value{};
+    };
+
+    void enqueue(Node *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    std::atomic<Node *> m_head;  // Most recently pushed node (producers)
+    Node *m_tail;                // Next node to pop (consumer only)
+    Node m_stub;
+};
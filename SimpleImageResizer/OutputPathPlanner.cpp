@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "OutputPathPlanner.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+QString OutputPathPlanner::key(const QString &name)
+{
+    // Match the case sensitivity QFile::exists has on the default file systems
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    return name.toCaseFolded();
+#else
+    return name;
+#endif
+}
+
+bool OutputPathPlanner::ensureDirectory(const QString &dir)
+{
+    if (m_dirEntries.contains(dir)) return true;
+    if (!QDir().mkpath(dir)) return false;
+    existingNames(dir);
+    return true;
+}
+
+const QSet<QString> &OutputPathPlanner::existingNames(const QString &dir)
+{
+    auto it = m_dirEntries.find(dir);
+    if (it != m_dirEntries.end()) return *it;
+
+    // One unsorted listing replaces a stat call per candidate name
+    QSet<QString> names;
+    QDirIterator dirIt(dir, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+    while (dirIt.hasNext()) {
+        dirIt.next();
+        names.insert(key(dirIt.fileName()));
+    }
+    return *m_dirEntries.insert(dir, names);
+}
+
+bool OutputPathPlanner::existsOnDisk(const QString &dir, const QString &fileName)
+{
+    return existingNames(dir).contains(key(fileName));
+}
+
+bool OutputPathPlanner::isAssigned(const QString &path) const
+{
+    return m_assigned.contains(key(path));
+}
+
+bool OutputPathPlanner::anyOnDisk(const QString &dir, const QString &stemName, const QStringList &exts)
+{
+    for (const QString &ext : exts) {
+        if (existsOnDisk(dir, stemName + ext)) return true;
+    }
+    return false;
+}
+
+bool OutputPathPlanner::anyAssigned(const QString &stem, const QStringList &exts) const
+{
+    for (const QString &ext : exts) {
+        if (isAssigned(stem + ext)) return true;
+    }
+    return false;
+}
+
+QString OutputPathPlanner::plan(const QString &inputPath, const QString &outputDir, const QStringList &exts)
+{
+    QFileInfo info(inputPath);
+    QString baseName = info.completeBaseName();
+    QDir dir(outputDir);
+    QString stemName = baseName;
+
+    // If output would overwrite input, append _resized. The input exists, so
+    // only names already on disk need the (stat-ing) identity check.
+    for (const QString &ext : exts) {
+        if (existsOnDisk(outputDir, baseName + ext) && QFileInfo(dir.filePath(baseName + ext)) == info) {
+            stemName = baseName + "_resized";
+            break;
+        }
+    }
+
+    // Avoid overwriting existing output files. The listing never changes, so
+    // the first free suffix for a base name is resolved once.
+    const QString extsKey = exts.join(QLatin1Char('|'));
+    if (anyOnDisk(outputDir, stemName, exts)) {
+        QString counterKey = key(dir.filePath(baseName) + extsKey);
+        auto it = m_diskCounters.find(counterKey);
+        if (it == m_diskCounters.end()) {
+            int counter = 1;
+            int found = 0;
+            do {
+                found = counter;
+                ++counter;
+                if (counter > 10000) { // Safety limit
+                    found = 0;
+                    break;
+                }
+            } while (anyOnDisk(outputDir, baseName + QString("_%1").arg(found), exts));
+            it = m_diskCounters.insert(counterKey, found);
+        }
+        if (*it > 0)
+            stemName = baseName + QString("_%1").arg(*it);
+    }
+
+    // Deduplicate against already-assigned paths in this batch (handles same-named
+    // files from different dirs). Occupied names never become free again, so the
+    // search for a base name resumes where the previous one stopped.
+    QString stem = dir.filePath(stemName);
+    if (anyAssigned(stem, exts)) {
+        QString counterKey = key(stem + extsKey);
+        int counter = m_batchCounters.value(counterKey, 1);
+        QString candidateName;
+        QString candidate;
+        do {
+            candidateName = stemName + QString("_%1").arg(counter);
+            candidate = dir.filePath(candidateName);
+            ++counter;
+        } while (anyAssigned(candidate, exts) || anyOnDisk(outputDir, candidateName, exts));
+        m_batchCounters.insert(counterKey, counter);
+        stem = candidate;
+    }
+
+    for (const QString &ext : exts)
+        m_assigned.insert(key(stem + ext));
+    return stem;
+}
+
+void OutputPathPlanner::reserve(const QString &stem, const QStringList &exts)
+{
+    for (const QString &ext : exts)
+        m_assigned.insert(key(stem + ext));
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Assigns collision-free output paths for a batch. Each output directory is
+// listed once into a hash set; collisions with existing files and with paths
+// already assigned in this batch are then resolved in memory.
+//
+// Not thread-safe: callers sharing a planner must serialise access. One
+// planner lives for a whole batch, so jobs planned late cannot collide with
+// earlier ones.
+class OutputPathPlanner {
+public:
+    // Creates the directory if needed. Returns false if it cannot be created.
+    bool ensureDirectory(const QString &dir);
+
+    // Output path, without extension, for inputPath inside outputDir. It is
+    // free under every one of exts (e.g. ".jpg"), so outputs whose format is
+    // chosen when they are encoded can take any of them: unique within the
+    // batch and not clashing with anything that existed when the directory
+    // was first seen. The directory must have been passed to ensureDirectory().
+    QString plan(const QString &inputPath, const QString &outputDir, const QStringList &exts);
+
+    // Marks stem under every one of exts as taken, for outputs planned by a
+    // previous planner that have not been written yet
+    void reserve(const QString &stem, const QStringList &exts);
+
+private:
+    const QSet<QString> &existingNames(const QString &dir);
+    bool existsOnDisk(const QString &dir, const QString &fileName);
+    bool isAssigned(const QString &path) const;
+    bool anyOnDisk(const QString &dir, const QString &stemName, const QStringList &exts);
+    bool anyAssigned(const QString &stem, const QStringList &exts) const;
+    static QString key(const QString &name);
+
+    QHash<QString, QSet<QString>> m_dirEntries;  // Directory -> keys of names on disk
+    QSet<QString> m_assigned;                    // Keys of paths handed out so far
+    QHash<QString, int> m_diskCounters;          // Base path + exts -> first free suffix on disk (0 = none)
+    QHash<QString, int> m_batchCounters;         // Base path + exts -> next suffix to try in this batch
+};
@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "PreviewPanel.h"
+#include "ImageProcessor.h"
+#include "InputFileModel.h"
+#include <QCheckBox>
+#include <QFile>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+
+static constexpr int DEBOUNCE_MS = 40;
+static constexpr int CROP_SIZE = 512;                       // Side of the centre crop in pixels
+static constexpr qint64 CACHE_BUDGET = 64 * 1024 * 1024;    // Decoded previews kept
+static constexpr int PROGRESS_DELAY_MS = 150;               // Quick encodes never flash a status
+static constexpr int DISPLAY_SIZE = 1024;                   // Views never need more than this
+
+static QImage fitForDisplay(const QImage &img)
+{
+    if (img.width() <= DISPLAY_SIZE && img.height() <= DISPLAY_SIZE) return img;
+    return img.scaled(DISPLAY_SIZE, DISPLAY_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+PreviewPanel::PreviewPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    // Two threads so a fresh request never queues behind a stale AVIF encode
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(2);
+    m_encodedCache.setMaxCost(CACHE_BUDGET);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    auto *viewsLayout = new QHBoxLayout;
+    m_beforeView = new QLabel;
+    m_afterView = new QLabel;
+    for (QLabel *view : {m_beforeView, m_afterView}) {
+        view->setAlignment(Qt::AlignCenter);
+        view->setMinimumSize(120, 120);
+        view->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+        view->setStyleSheet("QLabel { background: #202020; color: #aaa; }");
+        viewsLayout->addWidget(view);
+    }
+    m_beforeView->setToolTip("Before: the input after resizing");
+    m_afterView->setToolTip("After: the encoded output");
+    layout->addLayout(viewsLayout, 1);
+
+    auto *infoLayout = new QHBoxLayout;
+    m_infoLabel = new QLabel("Select an input file to preview the current settings");
+    m_infoLabel->setWordWrap(true);
+    infoLayout->addWidget(m_infoLabel, 1);
+    m_cropCheck = new QCheckBox("Crop at 100%");
+    m_cropCheck->setToolTip(QString("Encode and show only the central %1 x %1 pixels. "
+                                    "Much faster for large outputs; the size shown is an estimate.")
+                                .arg(CROP_SIZE));
+    infoLayout->addWidget(m_cropCheck);
+    layout->addLayout(infoLayout);
+
+    m_debounceTimer = new QTimer(this);
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(DEBOUNCE_MS);
+    connect(m_debounceTimer, &QTimer::timeout, this, &PreviewPanel::startRequest);
+
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(100);
+    connect(m_progressTimer, &QTimer::timeout, this, &PreviewPanel::updateProgress);
+
+    connect(m_cropCheck, &QCheckBox::toggled, m_debounceTimer, qOverload<>(&QTimer::start));
+}
+
+PreviewPanel::~PreviewPanel()
+{
+    if (m_cancelFlag) *m_cancelFlag = true;
+    m_pool->waitForDone();
+}
+
+void PreviewPanel::setImage(const QString &path)
+{
+    if (path == m_path) return;
+    m_path = path;
+    m_debounceTimer->start();
+}
+
+void PreviewPanel::setSettings(std::shared_ptr<const ProcessingSettings> settings)
+{
+    m_settings = std::move(settings);
+    m_debounceTimer->start();
+}
+
+bool PreviewPanel::encodesCrop() const
+{
+    // A target size applies to the whole file, so it cannot be searched on a crop
+    return m_cropCheck->isChecked() && !(m_settings && m_settings->useTargetSize);
+}
+
+QString PreviewPanel::sourceKey() const
+{
+    const ProcessingSettings &s = *m_settings;
+    return QString("%1|%2|%3|%4|%5").arg(m_path).arg(static_cast<int>(s.resizeMode))
+        .arg(s.resizePercent).arg(s.resizeWidth).arg(s.resizeHeight);
+}
+
+QString PreviewPanel::encodeKey() const
+{
+    // Only the values that affect the output, so equivalent settings share a result
+    const ProcessingSettings &s = *m_settings;
+    QString key = sourceKey() + '|' + QString::number(static_cast<int>(s.format));
+    bool targetSize = s.useTargetSize && s.format != OutputFormat::PNG;
+    if (targetSize)
+        key += "|t" + QString::number(s.targetSizeKB);
+    else if (s.format != OutputFormat::PNG)
+        key += "|q" + QString::number(s.quality);
+    // Auto may encode in any format, so every format's options count
+    const bool isAuto = s.format == OutputFormat::Auto;
+    if (s.format == OutputFormat::JPEG || isAuto)
+        key += QString("|j%1%2%3%4").arg(static_cast<int>(s.jpegSubsampling)).arg(int(s.jpegOptimizeCoding))
+                   .arg(int(s.jpegProgressive)).arg(int(s.jpegFastDct));
+    if (s.format == OutputFormat::WebP || isAuto)
+        key += "|w" + QString::number(static_cast<int>(s.webpSpeed));
+    if (s.format == OutputFormat::AVIF || isAuto)
+        key += QString("|a%1b%2").arg(static_cast<int>(s.avifSpeed)).arg(s.avifTimeBudgetMs);
+    if (encodesCrop())
+        key += "|crop";
+    return key;
+}
+
+void PreviewPanel::startRequest()
+{
+    if (m_path.isEmpty() || !m_settings) {
+        showMessage("Select an input file to preview the current settings");
+        return;
+    }
+
+    // Anything still running is for older settings
+    ++m_generation;
+    if (m_cancelFlag) *m_cancelFlag = true;
+    m_cancelFlag.reset();
+
+    QString srcKey = sourceKey();
+    QString encKey = encodeKey();
+    std::shared_ptr<const Source> source = (m_source && m_source->key == srcKey) ? m_source : nullptr;
+    if (source) {
+        if (Encoded *cached = m_encodedCache.object(encKey)) {
+            m_requestRunning = false;
+            m_progressTimer->stop();
+            showPreview(*source, *cached);
+            return;
+        }
+    }
+
+    m_cancelFlag = std::make_shared<std::atomic<bool>>(false);
+    m_requestRunning = true;
+    m_requestClock.start();
+    m_progressTimer->start();
+
+    auto *watcher = new QFutureWatcher<Outcome>(this);
+    connect(watcher, &QFutureWatcher<Outcome>::finished, this, [this, watcher]() {
+        onRequestFinished(watcher);
+    });
+    watcher->setFuture(QtConcurrent::run(m_pool, &PreviewPanel::run, m_generation, m_path, m_settings,
+                                         source, srcKey, encKey, encodesCrop(), m_cancelFlag));
+}
+
+PreviewPanel::Outcome PreviewPanel::run(int generation, QString path,
+                                        std::shared_ptr<const ProcessingSettings> settings,
+                                        std::shared_ptr<const Source> source, QString sourceKey,
+                                        QString encodeKey, bool crop,
+                                        std::shared_ptr<std::atomic<bool>> cancelFlag)
+{
+    Outcome outcome;
+    outcome.generation = generation;
+    outcome.encodeKey = encodeKey;
+
+    if (!source) {
+        auto fresh = std::make_shared<Source>();
+        fresh->key = sourceKey;
+        QFile file(path);
+        QByteArray data;
+        if (file.open(QIODevice::ReadOnly))
+            data = file.readAll();
+        fresh->originalBytes = data.size();
+        // The preview decodes one image at a time, so it may use every core
+        QImage img = ImageProcessor::loadImage(data, cancelFlag.get(), QThread::idealThreadCount());
+        if (!img.isNull())
+            fresh->resized = ImageProcessor::resizeImage(img, *settings, cancelFlag.get());
+        // A cancelled decode is not an unreadable file, so nothing is kept
+        if (cancelFlag->load()) {
+            outcome.cancelled = true;
+            return outcome;
+        }
+        if (img.isNull())
+            fresh->error = "Cannot load " + path;
+        fresh->display = fitForDisplay(fresh->resized);
+        source = fresh;
+    }
+    outcome.source = source;
+    if (!source->error.isEmpty()) return outcome;
+    if (cancelFlag->load()) {
+        outcome.cancelled = true;
+        return outcome;
+    }
+
+    QImage input = source->resized;
+    if (crop && (input.width() > CROP_SIZE || input.height() > CROP_SIZE)) {
+        int w = qMin(CROP_SIZE, input.width());
+        int h = qMin(CROP_SIZE, input.height());
+        input = input.copy((input.width() - w) / 2, (input.height() - h) / 2, w, h);
+    }
+
+    auto encoded = std::make_shared<Encoded>();
+    encoded->cropped = (input.size() != source->resized.size());
+    QElapsedTimer clock;
+    clock.start();
+    QByteArray data;
+    ProcessingResult info;
+    ResultStatus status = ImageProcessor::encode(input, *settings, cancelFlag.get(), data, encoded->error,
+                                                 0, &info);
+    encoded->elapsedMs = clock.elapsed();
+    if (status == ResultStatus::Cancelled) {
+        outcome.cancelled = true;
+        return outcome;
+    }
+    if (status == ResultStatus::Success) {
+        encoded->decoded = ImageProcessor::loadImage(data, cancelFlag.get(), QThread::idealThreadCount());
+        if (cancelFlag->load()) {
+            outcome.cancelled = true;
+            return outcome;
+        }
+        if (!encoded->cropped)
+            encoded->decoded = fitForDisplay(encoded->decoded);
+        encoded->bytes = data.size();
+        if (settings->format == OutputFormat::Auto)
+            encoded->chosenFormat = ImageProcessor::formatExtension(info.format);
+        if (encoded->cropped) {
+            // Scale by area; good enough to compare settings against each other
+            double areaRatio = static_cast<double>(source->resized.width()) * source->resized.height()
+                             / (static_cast<double>(input.width()) * input.height());
+            encoded->bytes = static_cast<qint64>(data.size() * areaRatio);
+        }
+    }
+    outcome.encoded = encoded;
+    return outcome;
+}
+
+void PreviewPanel::onRequestFinished(QFutureWatcher<Outcome> *watcher)
+{
+    Outcome outcome = watcher->result();
+    watcher->deleteLater();
+
+    // Stale results are still worth caching for when the slider comes back
+    if (outcome.source && outcome.source->key.startsWith(m_path + '|') && outcome.source->error.isEmpty())
+        m_source = outcome.source;
+    if (outcome.encoded && outcome.encoded->error.isEmpty()) {
+        qint64 cost = qMax<qint64>(1, outcome.encoded->decoded.sizeInBytes());
+        m_encodedCache.insert(outcome.encodeKey, new Encoded(*outcome.encoded), cost);
+    }
+
+    if (outcome.generation != m_generation) return;
+    m_requestRunning = false;
+    m_progressTimer->stop();
+
+    if (outcome.cancelled) return;
+    if (!outcome.source->error.isEmpty()) {
+        showMessage(outcome.source->error);
+        return;
+    }
+    showPreview(*outcome.source, *outcome.encoded);
+}
+
+void PreviewPanel::showPreview(const Source &source, const Encoded &encoded)
+{
+    m_beforeImage = source.display;
+    if (encoded.cropped && !encoded.decoded.isNull()) {
+        int w = encoded.decoded.width();
+        int h = encoded.decoded.height();
+        m_beforeImage = source.resized.copy((source.resized.width() - w) / 2,
+                                            (source.resized.height() - h) / 2, w, h);
+    }
+    m_afterImage = encoded.decoded;
+    updateViews();
+
+    if (!encoded.error.isEmpty()) {
+        m_infoLabel->setText(encoded.error);
+        return;
+    }
+    QString text = QString("Output: %1%2").arg(encoded.cropped ? "~" : "")
+                       .arg(InputFileModel::formatSize(encoded.bytes));
+    if (source.originalBytes > 0) {
+        double pct = (1.0 - static_cast<double>(encoded.bytes) / source.originalBytes) * 100.0;
+        text += QString(" (%1% vs %2 original)").arg(QString::number(-pct, 'f', 1))
+                    .arg(InputFileModel::formatSize(source.originalBytes));
+    }
+    text += QString(" - %1 x %2 - encoded in %3 ms")
+                .arg(source.resized.width()).arg(source.resized.height()).arg(encoded.elapsedMs);
+    if (!encoded.chosenFormat.isEmpty())
+        text += " as " + encoded.chosenFormat.mid(1).toUpper();
+    if (encoded.cropped)
+        text += " (crop, size estimated)";
+    m_infoLabel->setText(text);
+}
+
+void PreviewPanel::showMessage(const QString &message)
+{
+    m_beforeImage = QImage();
+    m_afterImage = QImage();
+    updateViews();
+    m_infoLabel->setText(message);
+}
+
+void PreviewPanel::updateProgress()
+{
+    if (!m_requestRunning || m_requestClock.elapsed() < PROGRESS_DELAY_MS) return;
+    // The previous preview stays visible until the new one is ready
+    QString what = (m_settings && m_settings->format == OutputFormat::AVIF) ? "Encoding AVIF" : "Encoding";
+    m_infoLabel->setText(QString("%1... %2 s").arg(what)
+                             .arg(QString::number(m_requestClock.elapsed() / 1000.0, 'f', 1)));
+}
+
+void PreviewPanel::updateViews()
+{
+    const std::pair<QLabel *, const QImage *> views[] = {
+        {m_beforeView, &m_beforeImage}, {m_afterView, &m_afterImage}};
+    for (const auto &[view, image] : views) {
+        if (image->isNull()) {
+            view->setPixmap(QPixmap());
+            continue;
+        }
+        QSize target = image->size().boundedTo(view->size());
+        view->setPixmap(QPixmap::fromImage(
+            image->scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation)));
+    }
+}
+
+void PreviewPanel::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateViews();
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QWidget>
+
+#include "ProcessingJob.h"
+
+class QCheckBox;
+class QLabel;
+class QThreadPool;
+class QTimer;
+
+// Before/after preview of one input encoded with the current settings.
+// Changes are debounced, then the image is re-encoded on a background pool;
+// a newer request makes older ones stale (they are cancelled where the
+// encoder allows and never shown). The decoded and resized source is kept
+// per (image, resize settings) and encoded results per (image, settings),
+// so scrubbing back and forth over a slider only re-encodes new values.
+class PreviewPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit PreviewPanel(QWidget *parent = nullptr);
+    ~PreviewPanel() override;
+
+    void setImage(const QString &path);
+    void setSettings(std::shared_ptr<const ProcessingSettings> settings);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct Source {
+        QString key;
+        QImage resized;          // Input after the resize step, as it will be encoded
+        QImage display;          // resized, reduced for the view
+        qint64 originalBytes = 0;
+        QString error;
+    };
+    struct Encoded {
+        QImage decoded;          // What the output looks like, reduced for the view unless cropped
+        qint64 bytes = 0;        // Encoded size (estimated for the whole image when cropped)
+        qint64 elapsedMs = 0;
+        bool cropped = false;
+        QString chosenFormat;    // Extension picked for an Auto output, e.g. ".webp"
+        QString error;
+    };
+    struct Outcome {
+        int generation = 0;
+        std::shared_ptr<const Source> source;
+        QString encodeKey;
+        std::shared_ptr<const Encoded> encoded;
+        bool cancelled = false;
+    };
+
+    void startRequest();
+    void onRequestFinished(QFutureWatcher<Outcome> *watcher);
+    void showPreview(const Source &source, const Encoded &encoded);
+    void showMessage(const QString &message);
+    void updateProgress();
+    void updateViews();
+    bool encodesCrop() const;
+    QString sourceKey() const;
+    QString encodeKey() const;
+    static Outcome run(int generation, QString path, std::shared_ptr<const ProcessingSettings> settings,
+                       std::shared_ptr<const Source> source, QString sourceKey, QString encodeKey,
+                       bool crop, std::shared_ptr<std::atomic<bool>> cancelFlag);
+
+    QThreadPool *m_pool = nullptr;
+    QTimer *m_debounceTimer = nullptr;
+    QTimer *m_progressTimer = nullptr;
+    QElapsedTimer m_requestClock;
+
+    QLabel *m_beforeView = nullptr;
+    QLabel *m_afterView = nullptr;
+    QLabel *m_infoLabel = nullptr;
+    QCheckBox *m_cropCheck = nullptr;
+    QImage m_beforeImage;
+    QImage m_afterImage;
+
+    QString m_path;
+    std::shared_ptr<const ProcessingSettings> m_settings;
+    std::shared_ptr<const Source> m_source;
+    QCache<QString, Encoded> m_encodedCache;
+    int m_generation = 0;
+    bool m_requestRunning = false;
+    std::shared_ptr<std::atomic<bool>> m_cancelFlag;
+};
@@ -4,8 +4,11 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <QString>
 
+class ConcurrencyLimiter;
+
 enum class ResizeMode {
     Percentage,
     FitWidth,
@@ -18,13 +21,40 @@ enum class OutputFormat {
     JPEG,
     PNG,
     WebP,
-    AVIF
+    AVIF,
+    Auto  // Chosen per image from its content
 };
 
-struct ProcessingJob {
-    QString inputPath;
-    QString outputDir;
-    QString outputPath;  // Pre-computed by main thread to avoid race conditions
+// libwebp method tiers: encoder effort traded against file size
+enum class WebpSpeed {
+    Fast,
+    Balanced,
+    Smallest
+};
+
+// libaom speed presets; slower presets give smaller files at the same quality
+enum class AvifSpeed {
+    Fast,
+    Balanced,
+    Best
+};
+
+// What to do with inputs already in the output format at the output size
+enum class Passthrough {
+    Off,   // Re-encode like any other input
+    Copy,  // Copy the file (a copy-on-write clone where the filesystem supports it)
+    Link   // Hard-link the file, or copy when the output is on another volume
+};
+
+enum class JpegSubsampling {
+    Yuv420,
+    Yuv422,
+    Yuv444
+};
+
+// Settings shared by every job of a batch. Jobs point at one immutable copy;
+// only manifest entries with per-file overrides carry their own.
+struct ProcessingSettings {
     OutputFormat format = OutputFormat::JPEG;
     ResizeMode resizeMode = ResizeMode::Percentage;
     int resizePercent = 100;
@@ -33,5 +63,29 @@ struct ProcessingJob {
     int quality = 85;
     bool useTargetSize = false;
     qint64 targetSizeKB = 500;
+
+    // JPEG encoder options
+    JpegSubsampling jpegSubsampling = JpegSubsampling::Yuv420;
+    bool jpegOptimizeCoding = true;  // Per-image Huffman tables: smaller files, a little slower
+    bool jpegProgressive = false;    // Progressive scans (always with optimised tables)
+    bool jpegFastDct = false;        // Faster, slightly less accurate integer DCT
+
+    WebpSpeed webpSpeed = WebpSpeed::Balanced;
+    bool webpLossless = false;  // Set per image by Auto for graphics, not a user setting
+    AvifSpeed avifSpeed = AvifSpeed::Balanced;
+    int avifTimeBudgetMs = 0;  // > 0: pick the speed per image to encode within this time
+
+    Passthrough passthrough = Passthrough::Off;
+    bool neverLarger = false;  // Keep the original when the encode would come out larger
+};
+
+struct ProcessingJob {
+    QString inputPath;
+    QString outputDir;
+    QString outputPath;  // Planned by the scheduler before the job is started
+    std::shared_ptr<const ProcessingSettings> settings;
     std::atomic<bool> *cancelFlag = nullptr;
+    ConcurrencyLimiter *limiter = nullptr;  // Shared I/O and CPU slot limits
+    int decodeThreads = 1;                  // Threads a decoder that can split its work may use
+    qint64 index = -1;                      // Position in the job source, echoed back in the result
 };
@@ -3,13 +3,17 @@
 
 #pragma once
 
+#include <memory>
 #include <QString>
 
+#include "ProcessingJob.h"
+
 enum class ResultStatus {
     Success,
     FailedToLoad,
     FailedToSave,
-    Cancelled
+    Cancelled,
+    KeptOriginal  // Re-encoding would not have made the file smaller
 };
 
 struct ProcessingResult {
@@ -23,6 +27,16 @@ struct ProcessingResult {
     int newHeight = 0;
     ResultStatus status = ResultStatus::Success;
     QString errorMessage;
+    qint64 index = -1;  // Copied from ProcessingJob::index
+    std::shared_ptr<const ProcessingSettings> settings;  // The job's settings, set by the scheduler
+
+    // Measured stage times, fed back into the scheduler's cost model
+    qint64 decodeUs = 0;
+    qint64 resizeUs = 0;
+    qint64 encodeUs = 0;
+    OutputFormat format = OutputFormat::JPEG;  // Format the output was encoded in; resolves Auto
+    int avifSpeed = -1;  // libaom speed the output was encoded at; -1 for other formats
+    bool passedThrough = false;  // Output is the input file copied or linked, not re-encoded
 
     double reductionPercent() const {
         if (originalSize <= 0) return 0.0;
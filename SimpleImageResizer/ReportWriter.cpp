@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ReportWriter.h"
+#include "ImageProcessor.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static QByteArray csvField(const QString &value)
+{
+    QByteArray utf8 = value.toUtf8();
+    if (!utf8.contains(',') && !utf8.contains('"') && !utf8.contains('\n') && !utf8.contains('\r'))
+        return utf8;
+    utf8.replace("\"", "\"\"");
+    return '"' + utf8 + '"';
+}
+
+// Format the output was written in, e.g. "webp"; empty when nothing was encoded
+static QString outputFormat(const ProcessingResult &result)
+{
+    if (result.status != ResultStatus::Success) return {};
+    return ImageProcessor::formatExtension(result.format).mid(1);
+}
+
+ReportWriter::ReportWriter(Format format, const QString &directory)
+    : m_format(format)
+    , m_directory(directory)
+{
+}
+
+QString ReportWriter::statusName(ResultStatus status)
+{
+    switch (status) {
+    case ResultStatus::Success:      return "success";
+    case ResultStatus::FailedToLoad: return "failed_to_load";
+    case ResultStatus::FailedToSave: return "failed_to_save";
+    case ResultStatus::Cancelled:    return "cancelled";
+    case ResultStatus::KeptOriginal: return "kept_original";
+    }
+    return {};
+}
+
+bool ReportWriter::open(const ProcessingResult &first)
+{
+    QString dir = m_directory;
+    if (dir.isEmpty()) {
+        dir = QFileInfo(first.outputPath.isEmpty() ? first.inputPath : first.outputPath).absolutePath();
+        QDir().mkpath(dir);
+    }
+    QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+    QString ext = (m_format == Format::Csv) ? "csv" : "jsonl";
+    m_file.setFileName(QDir(dir).filePath("resize-report-" + stamp + "." + ext));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_failed = true;
+        return false;
+    }
+    if (m_format == Format::Csv)
+        writeLine("row,input,output,status,original_size,new_size,original_width,original_height,"
+                  "new_width,new_height,format,avif_speed,passthrough,message");
+    return true;
+}
+
+void ReportWriter::writeLine(const QByteArray &line)
+{
+    m_buffer += line;
+    m_buffer += '\n';
+}
+
+void ReportWriter::consume(const ProcessingResult &result)
+{
+    if (m_failed) return;
+    if (!m_file.isOpen() && !open(result)) return;
+
+    if (m_format == Format::Csv) {
+        QByteArray line = QByteArray::number(result.index + 1) + ',' + csvField(result.inputPath) + ',' + csvField(result.outputPath) + ','
+                          + statusName(result.status).toUtf8() + ','
+                          + QByteArray::number(result.originalSize) + ','
+                          + QByteArray::number(result.newSize) + ','
+                          + QByteArray::number(result.originalWidth) + ','
+                          + QByteArray::number(result.originalHeight) + ','
+                          + QByteArray::number(result.newWidth) + ','
+                          + QByteArray::number(result.newHeight) + ','
+                          + outputFormat(result).toUtf8() + ','
+                          + (result.avifSpeed >= 0 ? QByteArray::number(result.avifSpeed) : QByteArray()) + ','
+                          + (result.passedThrough ? "1" : "0") + ','
+                          + csvField(result.errorMessage);
+        writeLine(line);
+    } else {
+        QJsonObject obj;
+        obj["row"] = result.index + 1;
+        obj["input"] = result.inputPath;
+        obj["output"] = result.outputPath;
+        obj["status"] = statusName(result.status);
+        obj["originalSize"] = result.originalSize;
+        obj["newSize"] = result.newSize;
+        obj["originalWidth"] = result.originalWidth;
+        obj["originalHeight"] = result.originalHeight;
+        obj["newWidth"] = result.newWidth;
+        obj["newHeight"] = result.newHeight;
+        if (!outputFormat(result).isEmpty())
+            obj["format"] = outputFormat(result);
+        if (result.avifSpeed >= 0)
+            obj["avifSpeed"] = result.avifSpeed;
+        if (result.passedThrough)
+            obj["passthrough"] = true;
+        if (!result.errorMessage.isEmpty())
+            obj["message"] = result.errorMessage;
+        writeLine(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    }
+}
+
+void ReportWriter::flush()
+{
+    if (m_failed || m_buffer.isEmpty()) return;
+    if (m_file.write(m_buffer) != m_buffer.size())
+        m_failed = true;
+    m_buffer.clear();
+    m_file.flush();
+}
+
+void ReportWriter::finish(bool cancelled)
+{
+    Q_UNUSED(cancelled);
+    flush();
+    m_file.close();
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include "ResultSink.h"
+
+// Appends one line per result to a CSV or JSON Lines report as the batch
+// runs, so the report is complete up to the last drain even if the
+// application is closed mid-batch.
+class ReportWriter : public ResultSink {
+public:
+    enum class Format { None, Csv, JsonLines };
+
+    // The report gets a timestamped name in directory, or if that is empty,
+    // in the output folder of the first result
+    ReportWriter(Format format, const QString &directory);
+
+    void consume(const ProcessingResult &result) override;
+    void flush() override;
+    void finish(bool cancelled) override;
+
+    QString filePath() const { return m_file.fileName(); }
+    bool failed() const { return m_failed; }
+
+    static QString statusName(ResultStatus status);
+
+private:
+    bool open(const ProcessingResult &first);
+    void writeLine(const QByteArray &line);
+
+    Format m_format;
+    QString m_directory;
+    QFile m_file;
+    QByteArray m_buffer;
+    bool m_failed = false;
+};
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ResultDispatcher.h"
+#include "ResultSink.h"
+
+void ResultDispatcher::addSink(ResultSink *sink)
+{
+    if (sink && !m_sinks.contains(sink))
+        m_sinks << sink;
+}
+
+void ResultDispatcher::removeSink(ResultSink *sink)
+{
+    m_sinks.removeAll(sink);
+}
+
+void ResultDispatcher::begin()
+{
+    for (ResultSink *sink : std::as_const(m_sinks))
+        sink->begin();
+}
+
+int ResultDispatcher::drain()
+{
+    int count = 0;
+    ProcessingResult result;
+    while (m_queue.tryPop(result)) {
+        for (ResultSink *sink : std::as_const(m_sinks))
+            sink->consume(result);
+        ++count;
+    }
+    if (count > 0) {
+        for (ResultSink *sink : std::as_const(m_sinks))
+            sink->flush();
+    }
+    return count;
+}
+
+void ResultDispatcher::finish(bool cancelled)
+{
+    drain();
+    for (ResultSink *sink : std::as_const(m_sinks))
+        sink->finish(cancelled);
+}
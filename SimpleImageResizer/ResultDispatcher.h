@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QList>
+
+#include "MpscQueue.h"
+#include "ProcessingResult.h"
+
+class ResultSink;
+
+// Hands results from worker threads to the registered sinks. Workers push
+// into a lock-free queue and never wait on the GUI; the GUI drains the queue
+// on its update timer, so a result lives only from the moment its job ends
+// until the next drain.
+class ResultDispatcher {
+public:
+    void addSink(ResultSink *sink);
+    void removeSink(ResultSink *sink);
+
+    // Thread-safe; called by workers
+    void push(ProcessingResult result) { m_queue.push(std::move(result)); }
+
+    // GUI thread only
+    void begin();
+    int drain();  // Returns the number of results handed out
+    void finish(bool cancelled);
+
+private:
+    MpscQueue<ProcessingResult> m_queue;
+    QList<ResultSink *> m_sinks;
+};
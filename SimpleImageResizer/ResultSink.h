@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include "ProcessingResult.h"
+
+// Consumer of per-file outcomes. Sinks are fed on the GUI thread by
+// ResultDispatcher::drain() and should keep only what they need from each
+// result; nothing holds on to the full result once every sink has seen it.
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+
+    virtual void begin() {}
+    virtual void consume(const ProcessingResult &result) = 0;
+    // Called after each drained run of results
+    virtual void flush() {}
+    virtual void finish(bool cancelled) { Q_UNUSED(cancelled); }
+};
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ResultsModel.h"
+#include "InputFileModel.h"
+#include <QColor>
+
+ResultsModel::ResultsModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int ResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int ResultsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+double ResultsModel::reductionPercent(const Row &r)
+{
+    if (r.originalSize <= 0) return 0.0;
+    return (1.0 - static_cast<double>(r.newSize) / static_cast<double>(r.originalSize)) * 100.0;
+}
+
+QString ResultsModel::text(int row, int column) const
+{
+    const Row &r = m_rows.at(row);
+    switch (column) {
+    case NameColumn:
+        return InputFileModel::fileName(r.inputPath);
+    case OriginalSizeColumn:
+        return InputFileModel::formatSize(r.originalSize);
+    case NewSizeColumn:
+        return InputFileModel::formatSize(r.newSize);
+    case ReductionColumn:
+        if (r.status != ResultStatus::Success) return "-";
+        return QString::number(reductionPercent(r), 'f', 1) + "%";
+    case StatusColumn:
+        if (r.status == ResultStatus::Success)
+            return r.message.isEmpty() ? QString("OK") : "OK (" + r.message + ")";
+        if (r.status == ResultStatus::Cancelled)
+            return "Cancelled";
+        if (r.status == ResultStatus::KeptOriginal)
+            return "Kept original";
+        return r.message;
+    }
+    return {};
+}
+
+QVariant ResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) return {};
+
+    if (role == Qt::DisplayRole)
+        return text(index.row(), index.column());
+
+    if (role == Qt::ForegroundRole) {
+        const Row &r = m_rows.at(index.row());
+        if (index.column() == ReductionColumn && r.status == ResultStatus::Success) {
+            double pct = reductionPercent(r);
+            if (pct > 50)      return QColor(0, 150, 0);
+            else if (pct > 20) return QColor(0, 100, 200);
+            else if (pct < 0)  return QColor(200, 0, 0);
+        } else if (index.column() == StatusColumn) {
+            if (r.status == ResultStatus::Cancelled || r.status == ResultStatus::KeptOriginal)
+                return QColor(150, 150, 150);
+            if (r.status != ResultStatus::Success)
+                return QColor(Qt::red);
+        }
+    }
+    return {};
+}
+
+QVariant ResultsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) return {};
+    if (orientation == Qt::Vertical) {
+        // Rows arrive in completion order; label them with their input's position
+        qint64 index = section < m_rows.size() ? m_rows.at(section).index : -1;
+        return index >= 0 ? index + 1 : section + 1;
+    }
+    switch (section) {
+    case NameColumn:         return QString("File Name");
+    case OriginalSizeColumn: return QString("Original Size");
+    case NewSizeColumn:      return QString("New Size");
+    case ReductionColumn:    return QString("Reduction %");
+    case StatusColumn:       return QString("Status");
+    }
+    return {};
+}
+
+void ResultsModel::consume(const ProcessingResult &result)
+{
+    Row row;
+    row.inputPath = result.inputPath;
+    row.message = result.errorMessage;
+    row.index = result.index;
+    row.originalSize = result.originalSize;
+    row.newSize = result.newSize;
+    row.status = result.status;
+    m_incoming << row;
+}
+
+void ResultsModel::flush()
+{
+    if (m_incoming.isEmpty()) return;
+    int first = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(m_incoming.size()) - 1);
+    m_rows += m_incoming;
+    endInsertRows();
+    m_incoming.clear();
+}
+
+void ResultsModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_rows.squeeze();
+    m_incoming.clear();
+    endResetModel();
+}
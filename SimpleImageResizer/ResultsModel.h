@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QList>
+
+#include "ProcessingResult.h"
+#include "ResultSink.h"
+
+// Per-file outcomes backing the results table, one row per finished file in
+// completion order. As a result sink it collects results without notifying
+// views; flush() inserts everything collected since the last flush as one
+// row range, so the GUI repaints on its own timer rather than once per
+// finished image.
+class ResultsModel : public QAbstractTableModel, public ResultSink {
+    Q_OBJECT
+
+public:
+    enum Column { NameColumn, OriginalSizeColumn, NewSizeColumn, ReductionColumn, StatusColumn, ColumnCount };
+
+    explicit ResultsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void clear();
+
+    QString text(int row, int column) const;
+
+    // ResultSink
+    void consume(const ProcessingResult &result) override;
+    void flush() override;
+
+private:
+    struct Row {
+        QString inputPath;      // Shared with the job, not copied
+        QString message;        // Usually empty
+        qint64 index = -1;      // Position in the batch's source, shown as the row header
+        qint64 originalSize = 0;
+        qint64 newSize = 0;
+        ResultStatus status = ResultStatus::Success;
+    };
+
+    static double reductionPercent(const Row &r);
+
+    QList<Row> m_rows;
+    QList<Row> m_incoming;  // Consumed but not yet inserted
+};
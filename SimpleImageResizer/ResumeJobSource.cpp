@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ResumeJobSource.h"
+#include "BatchJournal.h"
+
+ResumeJobSource::ResumeJobSource(std::shared_ptr<JobSource> inner, QSet<QString> finished,
+                                 std::shared_ptr<const ProcessingSettings> defaults)
+    : m_inner(std::move(inner))
+    , m_finished(std::move(finished))
+    , m_defaults(std::move(defaults))
+    , m_defaultHash(BatchJournal::settingsHash(*m_defaults))
+{
+}
+
+JobSource::Status ResumeJobSource::next(JobEntry &entry)
+{
+    for (;;) {
+        Status status = m_inner->next(entry);
+        if (status != Status::Ready || !entry.error.isEmpty()) return status;
+        QString hash = entry.settings ? BatchJournal::settingsHash(*entry.settings) : m_defaultHash;
+        if (!m_finished.contains(BatchJournal::doneKey(hash, entry.inputPath))) return status;
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+qint64 ResumeJobSource::estimatedTotal() const
+{
+    return qMax<qint64>(0, m_inner->estimatedTotal() - m_skipped.load(std::memory_order_relaxed));
+}
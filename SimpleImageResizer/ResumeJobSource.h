@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <QSet>
+#include <QString>
+
+#include "JobSource.h"
+
+// Replays the source of an interrupted batch, leaving out the jobs its
+// journal records as finished with the same settings.
+class ResumeJobSource : public JobSource {
+public:
+    // finished: BatchJournal::doneKey() values; defaults: settings of entries without their own
+    ResumeJobSource(std::shared_ptr<JobSource> inner, QSet<QString> finished,
+                    std::shared_ptr<const ProcessingSettings> defaults);
+
+    Status next(JobEntry &entry) override;
+    void waitForMore(int timeoutMs) override { m_inner->waitForMore(timeoutMs); }
+    void cancel() override { m_inner->cancel(); }
+    bool withdraw(qint64 index, JobEntry &entry) override { return m_inner->withdraw(index, entry); }
+    qint64 estimatedTotal() const override;
+
+    qint64 skipped() const { return m_skipped.load(); }
+
+private:
+    std::shared_ptr<JobSource> m_inner;
+    const QSet<QString> m_finished;  // Read-only once constructed, so safe to share between workers
+    std::shared_ptr<const ProcessingSettings> m_defaults;
+    QString m_defaultHash;
+    std::atomic<qint64> m_skipped{0};
+};
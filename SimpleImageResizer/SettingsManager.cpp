@@ -11,6 +11,29 @@ SettingsManager &SettingsManager::instance()
     return mgr;
 }
 
+std::shared_ptr<ProcessingSettings> SettingsManager::processingSettings() const
+{
+    auto settings = std::make_shared<ProcessingSettings>();
+    settings->format = outputFormat();
+    settings->resizeMode = resizeMode();
+    settings->resizePercent = resizePercent();
+    settings->resizeWidth = resizeWidth();
+    settings->resizeHeight = resizeHeight();
+    settings->quality = quality();
+    settings->useTargetSize = useTargetSize();
+    settings->targetSizeKB = targetSizeKB();
+    settings->jpegSubsampling = jpegSubsampling();
+    settings->jpegOptimizeCoding = jpegOptimizeCoding();
+    settings->jpegProgressive = jpegProgressive();
+    settings->jpegFastDct = jpegFastDct();
+    settings->webpSpeed = webpSpeed();
+    settings->avifSpeed = avifSpeed();
+    settings->avifTimeBudgetMs = avifTimeBudgetMs();
+    settings->passthrough = passthrough();
+    settings->neverLarger = neverLarger();
+    return settings;
+}
+
 QString SettingsManager::outputDir() const
 {
     QSettings s;
@@ -119,6 +142,114 @@ void SettingsManager::setTargetSizeKB(qint64 kb)
     s.setValue("targetSizeKB", kb);
 }
 
+JpegSubsampling SettingsManager::jpegSubsampling() const
+{
+    QSettings s;
+    return static_cast<JpegSubsampling>(s.value("jpegSubsampling", 0).toInt());
+}
+
+void SettingsManager::setJpegSubsampling(JpegSubsampling subsampling)
+{
+    QSettings s;
+    s.setValue("jpegSubsampling", static_cast<int>(subsampling));
+}
+
+bool SettingsManager::jpegOptimizeCoding() const
+{
+    QSettings s;
+    return s.value("jpegOptimizeCoding", true).toBool();
+}
+
+void SettingsManager::setJpegOptimizeCoding(bool optimize)
+{
+    QSettings s;
+    s.setValue("jpegOptimizeCoding", optimize);
+}
+
+bool SettingsManager::jpegProgressive() const
+{
+    QSettings s;
+    return s.value("jpegProgressive", false).toBool();
+}
+
+void SettingsManager::setJpegProgressive(bool progressive)
+{
+    QSettings s;
+    s.setValue("jpegProgressive", progressive);
+}
+
+bool SettingsManager::jpegFastDct() const
+{
+    QSettings s;
+    return s.value("jpegFastDct", false).toBool();
+}
+
+void SettingsManager::setJpegFastDct(bool fast)
+{
+    QSettings s;
+    s.setValue("jpegFastDct", fast);
+}
+
+WebpSpeed SettingsManager::webpSpeed() const
+{
+    QSettings s;
+    return static_cast<WebpSpeed>(s.value("webpSpeed", static_cast<int>(WebpSpeed::Balanced)).toInt());
+}
+
+void SettingsManager::setWebpSpeed(WebpSpeed speed)
+{
+    QSettings s;
+    s.setValue("webpSpeed", static_cast<int>(speed));
+}
+
+AvifSpeed SettingsManager::avifSpeed() const
+{
+    QSettings s;
+    return static_cast<AvifSpeed>(s.value("avifSpeed", static_cast<int>(AvifSpeed::Balanced)).toInt());
+}
+
+void SettingsManager::setAvifSpeed(AvifSpeed speed)
+{
+    QSettings s;
+    s.setValue("avifSpeed", static_cast<int>(speed));
+}
+
+int SettingsManager::avifTimeBudgetMs() const
+{
+    QSettings s;
+    return s.value("avifTimeBudgetMs", 0).toInt();
+}
+
+void SettingsManager::setAvifTimeBudgetMs(int ms)
+{
+    QSettings s;
+    s.setValue("avifTimeBudgetMs", ms);
+}
+
+Passthrough SettingsManager::passthrough() const
+{
+    QSettings s;
+    return static_cast<Passthrough>(s.value("passthrough", static_cast<int>(Passthrough::Off)).toInt());
+}
+
+void SettingsManager::setPassthrough(Passthrough mode)
+{
+    QSettings s;
+    s.setValue("passthrough", static_cast<int>(mode));
+}
+
+bool SettingsManager::neverLarger() const
+{
+    QSettings s;
+    return s.value("neverLarger", false).toBool();
+}
+
+void SettingsManager::setNeverLarger(bool enabled)
+{
+    QSettings s;
+    s.setValue("neverLarger", enabled);
+}
+
 int SettingsManager::threadCount() const
 {
     QSettings s;
@@ -131,6 +262,42 @@ void SettingsManager::setThreadCount(int count)
     s.setValue("threadCount", count);
 }
 
+int SettingsManager::ioConcurrency() const
+{
+    QSettings s;
+    return s.value("ioConcurrency", qMax(1, QThread::idealThreadCount() - 1)).toInt();
+}
+
+void SettingsManager::setIoConcurrency(int count)
+{
+    QSettings s;
+    s.setValue("ioConcurrency", count);
+}
+
+int SettingsManager::reportFormat() const
+{
+    QSettings s;
+    return s.value("reportFormat", 0).toInt();
+}
+
+void SettingsManager::setReportFormat(int format)
+{
+    QSettings s;
+    s.setValue("reportFormat", format);
+}
+
+bool SettingsManager::isolatedWorkers() const
+{
+    QSettings s;
+    return s.value("isolatedWorkers", false).toBool();
+}
+
+void SettingsManager::setIsolatedWorkers(bool isolated)
+{
+    QSettings s;
+    s.setValue("isolatedWorkers", isolated);
+}
+
 int SettingsManager::lastActiveTab() const
 {
     QSettings s;
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <memory>
 #include <QString>
 #include "ProcessingJob.h"
 
@@ -10,6 +11,9 @@ class SettingsManager {
 public:
     static SettingsManager &instance();
 
+    // The saved output settings as one job settings object
+    std::shared_ptr<ProcessingSettings> processingSettings() const;
+
     QString outputDir() const;
     void setOutputDir(const QString &dir);
 
@@ -37,8 +41,34 @@ public:
     qint64 targetSizeKB() const;
     void setTargetSizeKB(qint64 kb);
 
+    JpegSubsampling jpegSubsampling() const;
+    void setJpegSubsampling(JpegSubsampling subsampling);
+    bool jpegOptimizeCoding() const;
+    void setJpegOptimizeCoding(bool optimize);
+    bool jpegProgressive() const;
+    void setJpegProgressive(bool progressive);
+    bool jpegFastDct() const;
+    void setJpegFastDct(bool fast);
+
+    WebpSpeed webpSpeed() const;
+    void setWebpSpeed(WebpSpeed speed);
+    AvifSpeed avifSpeed() const;
+    void setAvifSpeed(AvifSpeed speed);
+    int avifTimeBudgetMs() const;
+    void setAvifTimeBudgetMs(int ms);
+    Passthrough passthrough() const;
+    void setPassthrough(Passthrough mode);
+    bool neverLarger() const;
+    void setNeverLarger(bool enabled);
+
     int threadCount() const;
     void setThreadCount(int count);
+    int ioConcurrency() const;
+    void setIoConcurrency(int count);
+    int reportFormat() const;  // 0 = none, 1 = CSV, 2 = JSON Lines
+    void setReportFormat(int format);
+    bool isolatedWorkers() const;
+    void setIsolatedWorkers(bool isolated);
     int lastActiveTab() const;
     void setLastActiveTab(int index);
 
@@ -3,11 +3,104 @@
 
 #include "SimpleImageResizer.h"
 #include "MainWindow.h"
+#include "WatchDaemon.h"
+#include "WorkerProcess.h"
 
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <QCommandLineParser>
 #include <QIcon>
+#include <QTextStream>
+#include <QTimer>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+static constexpr int SIGNAL_POLL_MS = 100;
+
+static std::atomic<bool> s_stopRequested{false};
+
+// Matches "--name" and "--name=value", the two forms QCommandLineParser accepts
+static bool hasOption(int argc, char *argv[], const char *name)
+{
+    const qsizetype length = qstrlen(name);
+    for (int i = 1; i < argc; ++i) {
+        if (qstrncmp(argv[i], name, length) == 0 && (argv[i][length] == '\0' || argv[i][length] == '='))
+            return true;
+    }
+    return false;
+}
+
+// Only sets a flag: quit() is not safe to call from a signal handler
+static void requestStop(int)
+{
+    s_stopRequested.store(true, std::memory_order_relaxed);
+}
+
+// Headless hot-folder mode using the settings saved by the GUI
+static int runWatchDaemon(int argc, char *argv[])
+{
+#if defined(Q_OS_WIN)
+    // A GUI-subsystem executable has no console of its own; borrow the one
+    // it was started from so reports and errors are visible
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        std::freopen("CONOUT$", "w", stdout);
+        std::freopen("CONOUT$", "w", stderr);
+    }
+#endif
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Simple Image Resizer");
+    app.setOrganizationName("SimpleImageResizer");
+    QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath());
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Processes images dropped into hot folders with the saved settings.");
+    parser.addHelpOption();
+    QCommandLineOption watchOption("watch", "Folder to watch; may be given more than once.", "dir");
+    QCommandLineOption outputOption("output", "Output folder (default: a \"resized\" folder in each watched folder).",
+                                    "dir");
+    parser.addOptions({ watchOption, outputOption });
+    parser.process(app);
+
+    WatchDaemon daemon(parser.values(watchOption), parser.value(outputOption));
+    QString error;
+    if (!daemon.start(error)) {
+        QTextStream(stderr) << error << Qt::endl;
+        return 1;
+    }
+
+    // Ctrl+C or a service stop leaves the event loop instead of killing the
+    // process, so the daemon's destructor cancels and drains in-flight jobs
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    QTimer signalTimer;
+    QObject::connect(&signalTimer, &QTimer::timeout, &app, []() {
+        if (s_stopRequested.load(std::memory_order_relaxed))
+            QCoreApplication::quit();
+    });
+    signalTimer.start(SIGNAL_POLL_MS);
+    return app.exec();
+}
 
 int main(int argc, char *argv[])
 {
+    // Worker processes (see WorkerProcess) only need the image plugins
+    if (argc > 1 && qstrcmp(argv[1], WorkerProcess::WORKER_ARGUMENT) == 0) {
+        // Ctrl+C in a terminal reaches the whole process group; the parent
+        // decides when workers stop by closing their stdin
+        std::signal(SIGINT, SIG_IGN);
+        QCoreApplication app(argc, argv);
+        QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath());
+        return WorkerProcess::serve();
+    }
+    if (hasOption(argc, argv, "--watch"))
+        return runWatchDaemon(argc, argv);
+
     QApplication app(argc, argv);
     app.setApplicationName("Simple Image Resizer");
     app.setOrganizationName("SimpleImageResizer");
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "TableJobSource.h"
+
+TableJobSource::TableJobSource(const QList<InputFileInfo> &files, const QList<int> &rows)
+{
+    appendLocked(files, rows);
+}
+
+void TableJobSource::appendLocked(const QList<InputFileInfo> &files, const QList<int> &rows)
+{
+    m_pending.reserve(m_pending.size() + files.size());
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        JobEntry entry;
+        entry.inputPath = files[i].path;
+        entry.fileSize = files[i].size;
+        entry.pixels = qint64(files[i].width) * files[i].height;
+        entry.index = rows.value(i, -1);
+        m_pending << std::move(entry);
+    }
+    m_total += files.size();
+}
+
+bool TableJobSource::append(const QList<InputFileInfo> &files, const QList<int> &rows)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_drained || m_cancelled) return false;
+    if (files.isEmpty()) return true;
+    appendLocked(files, rows);
+    m_changed.wakeAll();
+    return true;
+}
+
+bool TableJobSource::reopen()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_drained || m_cancelled) return false;
+    m_closed = false;
+    return true;
+}
+
+void TableJobSource::close()
+{
+    QMutexLocker lock(&m_mutex);
+    m_closed = true;
+    m_changed.wakeAll();
+}
+
+void TableJobSource::cancel()
+{
+    QMutexLocker lock(&m_mutex);
+    m_closed = true;
+    m_cancelled = true;
+    m_pending.clear();
+    m_changed.wakeAll();
+}
+
+JobSource::Status TableJobSource::next(JobEntry &entry)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_pending.isEmpty() || m_cancelled) {
+        if (!m_closed) return Status::Waiting;
+        m_drained = true;
+        return Status::Exhausted;
+    }
+    // QList keeps the space freed at the front, so this stays O(1)
+    entry = m_pending.takeFirst();
+    return Status::Ready;
+}
+
+bool TableJobSource::withdraw(qint64 index, JobEntry &entry)
+{
+    QMutexLocker lock(&m_mutex);
+    for (qsizetype i = 0; i < m_pending.size(); ++i) {
+        if (m_pending[i].index == index) {
+            entry = m_pending.takeAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TableJobSource::waitForMore(int timeoutMs)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_pending.isEmpty() && !m_closed)
+        m_changed.wait(&m_mutex, timeoutMs);
+}
+
+qint64 TableJobSource::estimatedTotal() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_total;
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "InputScanner.h"
+#include "JobSource.h"
+
+// Job source fed from the input table. It stays open while folder scans are
+// still adding files: the GUI appends new paths and closes the source once
+// nothing more is coming, and idle workers wait for either. Until the
+// workers have drained it, the source can be reopened and appended to, so
+// files added during a batch join it. Sizes and dimensions probed by the
+// scanner are passed on for cost estimates; each entry is indexed by its
+// table row.
+class TableJobSource : public JobSource {
+public:
+    // rows: the table row of each file
+    TableJobSource(const QList<InputFileInfo> &files, const QList<int> &rows);
+
+    // GUI thread. Both return false once the workers have drained the source.
+    bool append(const QList<InputFileInfo> &files, const QList<int> &rows);
+    bool reopen();
+    void close();
+
+    Status next(JobEntry &entry) override;
+    void waitForMore(int timeoutMs) override;
+    void cancel() override;
+    bool withdraw(qint64 index, JobEntry &entry) override;
+    qint64 estimatedTotal() const override;
+
+private:
+    void appendLocked(const QList<InputFileInfo> &files, const QList<int> &rows);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_changed;
+    QList<JobEntry> m_pending;
+    qint64 m_total = 0;
+    bool m_closed = false;
+    bool m_drained = false;  // A worker has seen Exhausted
+    bool m_cancelled = false;
+};
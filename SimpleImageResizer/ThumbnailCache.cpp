@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "ThumbnailCache.h"
+#include "ImageProcessor.h"
+#include "InputScanner.h"
+#include <algorithm>
+#include <memory>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <QTransform>
+#include <libraw/libraw.h>
+
+static constexpr int THUMBNAIL_SIZE = 64;                     // Longest side in pixels
+static constexpr qint64 MEMORY_BUDGET = 64 * 1024 * 1024;     // Decoded pixels kept in memory
+static constexpr qint64 DISK_BUDGET = 256 * 1024 * 1024;      // Pruned to this at startup
+static constexpr int MAX_QUEUED = 256;
+static constexpr int WORKER_COUNT = 2;
+static constexpr int FLUSH_INTERVAL_MS = 100;
+
+static QImage fitThumbnail(const QImage &img)
+{
+    if (img.isNull() || (img.width() <= THUMBNAIL_SIZE && img.height() <= THUMBNAIL_SIZE))
+        return img;
+    return img.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+// Lets the decoder skip work for the reduced size (JPEG decodes at 1/2..1/8 scale)
+static QImage readScaled(QImageReader &reader)
+{
+    reader.setAutoTransform(true);
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > THUMBNAIL_SIZE || size.height() > THUMBNAIL_SIZE))
+        reader.setScaledSize(size.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio));
+    return fitThumbnail(reader.read());
+}
+
+// The camera's embedded preview; only the file headers and the preview are read
+static QImage loadRawThumbnail(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return {};
+    qint64 size = file.size();
+    uchar *mapped = file.map(0, size);
+    if (!mapped) return {};
+
+    auto rawOwner = std::make_unique<LibRaw>();
+    LibRaw &raw = *rawOwner;
+    if (raw.open_buffer(mapped, static_cast<size_t>(size)) != LIBRAW_SUCCESS) return {};
+    if (raw.unpack_thumb() != LIBRAW_SUCCESS) return {};
+    int error = 0;
+    libraw_processed_image_t *thumb = raw.dcraw_make_mem_thumb(&error);
+    if (!thumb) return {};
+
+    QImage img;
+    if (thumb->type == LIBRAW_IMAGE_JPEG) {
+        QByteArray jpeg = QByteArray::fromRawData(reinterpret_cast<const char *>(thumb->data),
+                                                  static_cast<qsizetype>(thumb->data_size));
+        QBuffer buffer(&jpeg);
+        QImageReader reader(&buffer, "jpeg");
+        img = readScaled(reader);
+    } else if (thumb->type == LIBRAW_IMAGE_BITMAP && thumb->colors == 3 && thumb->bits == 8) {
+        img = fitThumbnail(QImage(thumb->data, thumb->width, thumb->height,
+                                  thumb->width * 3, QImage::Format_RGB888));
+        if (img.constBits() == thumb->data) img = img.copy();  // Detach before freeing
+    }
+    raw.dcraw_clear_mem(thumb);
+
+    // Embedded previews are stored unrotated
+    switch (raw.imgdata.sizes.flip) {
+    case 3: img = img.transformed(QTransform().rotate(180)); break;
+    case 5: img = img.transformed(QTransform().rotate(270)); break;
+    case 6: img = img.transformed(QTransform().rotate(90));  break;
+    }
+    return img;
+}
+
+ThumbnailCache::ThumbnailCache(QObject *parent)
+    : QObject(parent)
+{
+    m_memory.setMaxCost(MEMORY_BUDGET);
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(WORKER_COUNT + 1);  // + the startup prune
+    m_pool->setThreadPriority(QThread::LowPriority);
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &ThumbnailCache::flush);
+
+    m_diskDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+    if (QDir().mkpath(m_diskDir))
+        m_pool->start([this]() { pruneDiskCache(); });
+    else
+        m_diskDir.clear();
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue.clear();
+    }
+    m_pool->waitForDone();
+}
+
+QPixmap ThumbnailCache::thumbnail(const QString &path)
+{
+    if (QPixmap *cached = m_memory.object(path))
+        return *cached;
+    if (m_requested.contains(path))
+        return {};
+
+    m_requested.insert(path);
+    QStringList dropped;
+    bool startWorker = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue << path;
+        // Rows scrolled past long ago are no longer on screen
+        while (m_queue.size() > MAX_QUEUED)
+            dropped << m_queue.takeFirst();
+        if (m_activeWorkers.load() < WORKER_COUNT) {
+            m_activeWorkers.fetch_add(1);
+            startWorker = true;
+        }
+    }
+    for (const QString &p : std::as_const(dropped))
+        m_requested.remove(p);
+    if (startWorker)
+        m_pool->start([this]() { workerLoop(); });
+    m_flushTimer->start();
+    return {};
+}
+
+void ThumbnailCache::cancelPending()
+{
+    QMutexLocker lock(&m_mutex);
+    for (const QString &p : std::as_const(m_queue))
+        m_requested.remove(p);
+    m_queue.clear();
+}
+
+void ThumbnailCache::workerLoop()
+{
+    for (;;) {
+        QString path;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_queue.isEmpty()) {
+                m_activeWorkers.fetch_sub(1);
+                return;
+            }
+            path = m_queue.takeLast();  // Most recently painted rows first
+        }
+        QImage img = loadThumbnail(path);
+        QMutexLocker lock(&m_mutex);
+        m_loaded.append({path, img});
+    }
+}
+
+QImage ThumbnailCache::loadThumbnail(const QString &path) const
+{
+    QFileInfo info(path);
+    QString diskPath;
+    if (!m_diskDir.isEmpty()) {
+        QByteArray key = path.toUtf8() + '\n'
+                       + QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + '\n'
+                       + QByteArray::number(info.size()) + '\n'
+                       + QByteArray::number(THUMBNAIL_SIZE);
+        diskPath = m_diskDir + '/'
+                 + QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() + ".png";
+        QImage cached;
+        if (cached.load(diskPath, "png"))
+            return cached;
+    }
+
+    QImage img;
+    if (InputScanner::isRawSuffix(info.suffix()))
+        img = loadRawThumbnail(path);
+    if (img.isNull()) {
+        QImageReader reader(path);
+        img = readScaled(reader);
+    }
+    if (img.isNull()) {
+        // Formats without a Qt plugin (AVIF) need a full decode
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            img = fitThumbnail(ImageProcessor::loadImage(file.readAll()));
+    }
+
+    if (!img.isNull() && !diskPath.isEmpty()) {
+        // Write under a temporary name so a concurrent reader never sees half a file
+        QString tmpPath = diskPath + ".tmp";
+        if (img.save(tmpPath, "png"))
+            QFile::rename(tmpPath, diskPath);
+        else
+            QFile::remove(tmpPath);
+    }
+    return img;
+}
+
+void ThumbnailCache::pruneDiskCache() const
+{
+    struct Entry { QString path; qint64 size; QDateTime modified; };
+    QList<Entry> entries;
+    qint64 total = 0;
+    QDirIterator it(m_diskDir, QDir::Files);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        entries.append({info.filePath(), info.size(), info.lastModified()});
+        total += info.size();
+    }
+    if (total <= DISK_BUDGET) return;
+
+    // Oldest first, down to 80% of the budget so this does not run every start
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.modified < b.modified; });
+    for (const Entry &entry : std::as_const(entries)) {
+        if (total <= DISK_BUDGET * 8 / 10) break;
+        if (QFile::remove(entry.path))
+            total -= entry.size;
+    }
+}
+
+void ThumbnailCache::flush()
+{
+    QList<QPair<QString, QImage>> loaded;
+    bool idle;
+    {
+        QMutexLocker lock(&m_mutex);
+        loaded.swap(m_loaded);
+        idle = m_queue.isEmpty() && m_activeWorkers.load() == 0;
+    }
+
+    for (const auto &[path, img] : std::as_const(loaded)) {
+        m_requested.remove(path);
+        // Failures are cached too (as an empty pixmap) so they are not retried
+        auto *pixmap = new QPixmap(QPixmap::fromImage(img));
+        qint64 cost = qMax<qint64>(1, static_cast<qint64>(img.sizeInBytes()));
+        m_memory.insert(path, pixmap, cost);
+    }
+    if (!loaded.isEmpty())
+        emit thumbnailsReady();
+    if (idle)
+        m_flushTimer->stop();
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+
+#include <QCache>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QPixmap>
+#include <QSet>
+#include <QStringList>
+
+class QThreadPool;
+class QTimer;
+
+// Small previews of input images. Thumbnails are decoded at reduced size
+// (scaled JPEG decode, or the preview embedded in RAW files) on a
+// low-priority pool and kept in two tiers: an in-memory LRU bounded by a
+// byte budget, and a disk cache keyed by path, modification time and size,
+// so re-opening a folder shows its thumbnails without decoding again.
+//
+// Requests are meant to come from views painting visible rows. The newest
+// requests are served first and old ones are dropped once the queue is
+// long, so scrolling quickly through a large list does not leave a backlog.
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailCache(QObject *parent = nullptr);
+    ~ThumbnailCache() override;
+
+    // GUI thread. Returns the thumbnail if it is in memory; otherwise queues
+    // it and returns a null pixmap. thumbnailsReady() follows once it loads.
+    QPixmap thumbnail(const QString &path);
+    // Drops queued requests; cached thumbnails are kept
+    void cancelPending();
+
+signals:
+    void thumbnailsReady();
+
+private:
+    void workerLoop();
+    void flush();
+    QImage loadThumbnail(const QString &path) const;
+    void pruneDiskCache() const;
+
+    QThreadPool *m_pool = nullptr;
+    QTimer *m_flushTimer = nullptr;
+    QString m_diskDir;
+
+    // GUI thread only
+    QCache<QString, QPixmap> m_memory;
+    QSet<QString> m_requested;  // Queued or being decoded
+
+    QMutex m_mutex;
+    QStringList m_queue;                      // Newest last
+    QList<QPair<QString, QImage>> m_loaded;   // Decoded, not yet moved to m_memory
+    std::atomic<int> m_activeWorkers{0};
+};
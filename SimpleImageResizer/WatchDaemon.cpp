@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "WatchDaemon.h"
+#include "BatchScheduler.h"
+#include "SettingsManager.h"
+#include "TableJobSource.h"
+#include <QDateTime>
+#include <QDir>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QTimer>
+
+static constexpr int DRAIN_INTERVAL_MS = 100;
+static constexpr int REPORT_INTERVAL_MS = 10000;
+
+static void printLine(const QString &line)
+{
+    QTextStream out(stdout);
+    out << QDateTime::currentDateTime().toString(Qt::ISODate) << ' ' << line << Qt::endl;
+}
+
+WatchDaemon::WatchDaemon(const QStringList &dirs, const QString &outputDir, QObject *parent)
+    : QObject(parent)
+    , m_dirs(dirs)
+    , m_outputDir(outputDir)
+{
+    m_pool = new QThreadPool(this);
+    m_scheduler = new BatchScheduler(m_pool, this);
+    m_watch = new WatchFolder(dirs, InputScanner::nameFilters(), this);
+    connect(m_watch, &WatchFolder::filesReady, this, &WatchDaemon::onFilesReady);
+
+    m_drainTimer = new QTimer(this);
+    m_drainTimer->setInterval(DRAIN_INTERVAL_MS);
+    connect(m_drainTimer, &QTimer::timeout, this, [this]() { m_dispatcher.drain(); });
+
+    m_reportTimer = new QTimer(this);
+    m_reportTimer->setInterval(REPORT_INTERVAL_MS);
+    connect(m_reportTimer, &QTimer::timeout, this, &WatchDaemon::report);
+}
+
+WatchDaemon::~WatchDaemon()
+{
+    if (m_source) {
+        m_scheduler->cancel();
+        m_scheduler->waitForDone();
+        m_dispatcher.finish(true);
+    }
+}
+
+bool WatchDaemon::start(QString &error)
+{
+    if (m_dirs.isEmpty()) {
+        error = "No folder to watch";
+        return false;
+    }
+    if (!m_outputDir.isEmpty()) {
+        // Outputs landing in a watched folder would be picked up again
+        QString output = QDir(m_outputDir).absolutePath();
+        for (const QString &dir : std::as_const(m_dirs)) {
+            if (QDir(dir).absolutePath() == output) {
+                error = "The output folder cannot be a watched folder";
+                return false;
+            }
+        }
+        if (!QDir().mkpath(output)) {
+            error = "Could not create output directory: " + m_outputDir;
+            return false;
+        }
+    }
+    const QStringList failed = m_watch->start();
+    if (!failed.isEmpty()) {
+        error = "Cannot watch: " + failed.join(", ");
+        return false;
+    }
+
+    SettingsManager &s = SettingsManager::instance();
+    m_source = std::make_shared<TableJobSource>(QList<InputFileInfo>(), QList<int>());
+    m_dispatcher.addSink(&m_stats);
+    m_dispatcher.begin();
+    m_drainTimer->start();
+    m_reportTimer->start();
+    m_scheduler->start(m_source, s.processingSettings(), m_outputDir, &m_dispatcher,
+                       s.ioConcurrency(), s.threadCount(), s.isolatedWorkers());
+    printLine(QString("Watching %1 folder(s) for new images").arg(m_dirs.size()));
+    return true;
+}
+
+void WatchDaemon::onFilesReady(const QList<WatchedFile> &files)
+{
+    QList<InputFileInfo> infos;
+    QList<int> rows;
+    for (const WatchedFile &file : files) {
+        m_stats.noteArrival(file.info.path, file.arrivedMs);
+        infos << file.info;
+        rows << m_nextRow++;
+    }
+    // The output folders may have been emptied, moved or written to since
+    // the last micro-batch
+    m_scheduler->replan();
+    m_source->append(infos, rows);
+}
+
+void WatchDaemon::report()
+{
+    QString line = m_stats.takeReport();
+    if (!line.isEmpty())
+        printLine(line);
+}
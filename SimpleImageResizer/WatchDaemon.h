@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <memory>
+#include <QObject>
+#include <QStringList>
+
+#include "ResultDispatcher.h"
+#include "WatchFolder.h"
+#include "WatchStats.h"
+
+class BatchScheduler;
+class QThreadPool;
+class QTimer;
+class TableJobSource;
+
+// Headless hot-folder mode (--watch). One batch runs for the daemon's whole
+// life with the saved settings: its table source never closes, and every
+// micro-batch from the folder watcher is appended to it, so workers pick up
+// new files as soon as they settle. Latency and throughput are printed
+// periodically.
+class WatchDaemon : public QObject {
+    Q_OBJECT
+
+public:
+    // outputDir empty: outputs go to a "resized" folder inside each watched folder
+    WatchDaemon(const QStringList &dirs, const QString &outputDir, QObject *parent = nullptr);
+    ~WatchDaemon() override;
+
+    bool start(QString &error);
+
+private:
+    void onFilesReady(const QList<WatchedFile> &files);
+    void report();
+
+    QStringList m_dirs;
+    QString m_outputDir;
+    QThreadPool *m_pool = nullptr;
+    BatchScheduler *m_scheduler = nullptr;
+    WatchFolder *m_watch = nullptr;
+    std::shared_ptr<TableJobSource> m_source;
+    ResultDispatcher m_dispatcher;
+    WatchStats m_stats;
+    QTimer *m_drainTimer = nullptr;
+    QTimer *m_reportTimer = nullptr;
+    int m_nextRow = 0;
+};
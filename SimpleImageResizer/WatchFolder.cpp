@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "WatchFolder.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QTimer>
+
+static constexpr int CHECK_INTERVAL_MS = 250;  // Re-stat of unsettled new files only
+static constexpr int STABLE_MS = 1000;         // Size and mtime must hold this long
+static constexpr int COALESCE_MS = 500;        // Settled files are collected this long per micro-batch
+static constexpr int MAX_BATCH = 64;           // Released at once when this many are ready
+
+WatchFolder::WatchFolder(const QStringList &dirs, const QStringList &nameFilters, QObject *parent)
+    : QObject(parent)
+    , m_dirs(dirs)
+    , m_nameFilters(nameFilters)
+{
+    m_checkTimer = new QTimer(this);
+    m_checkTimer->setInterval(CHECK_INTERVAL_MS);
+    connect(m_checkTimer, &QTimer::timeout, this, &WatchFolder::checkCandidates);
+
+    m_coalesceTimer = new QTimer(this);
+    m_coalesceTimer->setSingleShot(true);
+    m_coalesceTimer->setInterval(COALESCE_MS);
+    connect(m_coalesceTimer, &QTimer::timeout, this, &WatchFolder::releaseReady);
+
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &WatchFolder::onDirectoryChanged);
+}
+
+QStringList WatchFolder::start()
+{
+    QStringList failed;
+    for (const QString &dir : std::as_const(m_dirs)) {
+        QString path = QDir(dir).absolutePath();
+        if (!QFileInfo(path).isDir() || !m_watcher.addPath(path)) {
+            failed << dir;
+            continue;
+        }
+        // Whatever is already there counts as handled
+        QSet<QString> &seen = m_seen[path];
+        const QStringList names = QDir(path).entryList(m_nameFilters, QDir::Files);
+        for (const QString &name : names)
+            seen.insert(QDir(path).filePath(name));
+    }
+    return failed;
+}
+
+void WatchFolder::onDirectoryChanged(const QString &dir)
+{
+    QSet<QString> &seen = m_seen[dir];
+    QSet<QString> present;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QFileInfoList entries = QDir(dir).entryInfoList(m_nameFilters, QDir::Files);
+    for (const QFileInfo &entry : entries) {
+        QString path = entry.filePath();
+        present.insert(path);
+        if (seen.contains(path)) continue;
+        Candidate candidate;
+        candidate.arrivedMs = now;
+        candidate.size = entry.size();
+        candidate.modifiedMs = entry.lastModified().toMSecsSinceEpoch();
+        candidate.stableSinceMs = now;
+        m_candidates.insert(path, candidate);
+    }
+    // Forget deleted files so a file dropped again under the same name is processed again
+    seen = std::move(present);
+    if (!m_candidates.isEmpty() && !m_checkTimer->isActive())
+        m_checkTimer->start();
+}
+
+void WatchFolder::checkCandidates()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_candidates.begin(); it != m_candidates.end();) {
+        QFileInfo info(it.key());
+        if (!info.exists()) {
+            it = m_candidates.erase(it);
+            continue;
+        }
+        qint64 size = info.size();
+        qint64 modified = info.lastModified().toMSecsSinceEpoch();
+        if (size != it->size || modified != it->modifiedMs || size == 0) {
+            it->size = size;
+            it->modifiedMs = modified;
+            it->stableSinceMs = now;
+            ++it;
+            continue;
+        }
+        if (now - it->stableSinceMs < STABLE_MS) {
+            ++it;
+            continue;
+        }
+        WatchedFile file;
+        file.info = InputScanner::probe(it.key());
+        file.arrivedMs = it->arrivedMs;
+        m_ready << file;
+        it = m_candidates.erase(it);
+    }
+    if (m_candidates.isEmpty())
+        m_checkTimer->stop();
+
+    if (m_ready.size() >= MAX_BATCH)
+        releaseReady();
+    else if (!m_ready.isEmpty() && !m_coalesceTimer->isActive())
+        m_coalesceTimer->start();
+}
+
+void WatchFolder::releaseReady()
+{
+    m_coalesceTimer->stop();
+    if (m_ready.isEmpty()) return;
+    QList<WatchedFile> batch;
+    batch.swap(m_ready);
+    emit filesReady(batch);
+}
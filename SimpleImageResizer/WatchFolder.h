@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+#include "InputScanner.h"
+
+class QTimer;
+
+struct WatchedFile {
+    InputFileInfo info;
+    qint64 arrivedMs = 0;  // QDateTime::currentMSecsSinceEpoch() when first seen
+};
+
+// Watches hot folders for new images. Only the watched folders themselves
+// are listed, and only when the OS reports a change; files already present
+// at start are left alone. A new file is released once its size and
+// modification time have held still for a moment (so copies in progress are
+// not picked up half-written), and released files are coalesced into
+// micro-batches.
+class WatchFolder : public QObject {
+    Q_OBJECT
+
+public:
+    WatchFolder(const QStringList &dirs, const QStringList &nameFilters, QObject *parent = nullptr);
+
+    // Returns the folders that could not be watched
+    QStringList start();
+
+signals:
+    void filesReady(const QList<WatchedFile> &files);
+
+private:
+    struct Candidate {
+        qint64 arrivedMs = 0;
+        qint64 size = -1;
+        qint64 modifiedMs = 0;
+        qint64 stableSinceMs = 0;
+    };
+
+    void onDirectoryChanged(const QString &dir);
+    void checkCandidates();
+    void releaseReady();
+
+    QStringList m_dirs;
+    QStringList m_nameFilters;
+    QFileSystemWatcher m_watcher;
+    QHash<QString, QSet<QString>> m_seen;   // Per folder: paths present or already handled
+    QHash<QString, Candidate> m_candidates; // New files waiting to settle
+    QList<WatchedFile> m_ready;
+    QTimer *m_checkTimer = nullptr;
+    QTimer *m_coalesceTimer = nullptr;
+};
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "WatchStats.h"
+#include <algorithm>
+#include <QDateTime>
+
+void WatchStats::noteArrival(const QString &path, qint64 arrivedMs)
+{
+    m_arrivals.insert(path, arrivedMs);
+    if (m_intervalStartMs == 0)
+        m_intervalStartMs = QDateTime::currentMSecsSinceEpoch();
+}
+
+void WatchStats::consume(const ProcessingResult &result)
+{
+    qint64 arrived = m_arrivals.take(result.inputPath);
+    if (arrived > 0)
+        m_latenciesMs << QDateTime::currentMSecsSinceEpoch() - arrived;
+    if (result.status == ResultStatus::Success || result.status == ResultStatus::KeptOriginal)
+        m_inputBytes += result.originalSize;
+    else
+        ++m_failed;
+    ++m_totalProcessed;
+}
+
+QString WatchStats::takeReport()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_latenciesMs.isEmpty()) {
+        m_intervalStartMs = m_arrivals.isEmpty() ? 0 : now;
+        return {};
+    }
+    std::sort(m_latenciesMs.begin(), m_latenciesMs.end());
+    const qsizetype n = m_latenciesMs.size();
+    const double seconds = qMax<qint64>(1, now - m_intervalStartMs) / 1000.0;
+    QString report = QString("%1 file(s) in %2 s (%3/s, %4 MB/s in), latency median %5 s, "
+                             "p95 %6 s, max %7 s, %8 failed, %9 waiting")
+        .arg(n)
+        .arg(seconds, 0, 'f', 1)
+        .arg(n / seconds, 0, 'f', 2)
+        .arg(m_inputBytes / seconds / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(m_latenciesMs.at(n / 2) / 1000.0, 0, 'f', 2)
+        .arg(m_latenciesMs.at(qMin(n - 1, n * 95 / 100)) / 1000.0, 0, 'f', 2)
+        .arg(m_latenciesMs.last() / 1000.0, 0, 'f', 2)
+        .arg(m_failed)
+        .arg(m_arrivals.size());
+    m_latenciesMs.clear();
+    m_inputBytes = 0;
+    m_failed = 0;
+    m_intervalStartMs = now;
+    return report;
+}
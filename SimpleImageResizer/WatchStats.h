@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "ResultSink.h"
+
+// Watch-mode statistics: latency from a file landing in a hot folder to its
+// result, and throughput, summarised per reporting interval.
+class WatchStats : public ResultSink {
+public:
+    void noteArrival(const QString &path, qint64 arrivedMs);
+    void consume(const ProcessingResult &result) override;
+
+    // One line covering everything finished since the previous call;
+    // empty if nothing finished
+    QString takeReport();
+
+    qint64 totalProcessed() const { return m_totalProcessed; }
+
+private:
+    QHash<QString, qint64> m_arrivals;  // Files handed to the batch, not yet finished
+    QList<qint64> m_latenciesMs;        // This interval
+    qint64 m_inputBytes = 0;            // This interval
+    int m_failed = 0;                   // This interval
+    qint64 m_intervalStartMs = 0;
+    qint64 m_totalProcessed = 0;
+};
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "WebpCodec.h"
+#include <climits>
+#include <QColorSpace>
+#include <QImage>
+#include <webp/encode.h>
+#include <webp/mux.h>
+
+static constexpr int TARGET_SIZE_PASSES = 6;  // libwebp rate-control passes when aiming for a size
+
+static bool isCancelled(const std::atomic<bool> *cancelFlag)
+{
+    return cancelFlag && cancelFlag->load(std::memory_order_relaxed);
+}
+
+// libwebp calls this as it encodes; returning 0 aborts the encode
+static int webpProgress(int, const WebPPicture *picture)
+{
+    return isCancelled(static_cast<const std::atomic<bool> *>(picture->user_data)) ? 0 : 1;
+}
+
+// WebPConfigLosslessPreset levels, 0-9
+static int losslessLevelFor(WebpSpeed speed)
+{
+    switch (speed) {
+    case WebpSpeed::Fast:     return 2;
+    case WebpSpeed::Balanced: return 6;
+    case WebpSpeed::Smallest: return 9;
+    }
+    return 6;
+}
+
+static int methodFor(WebpSpeed speed)
+{
+    switch (speed) {
+    case WebpSpeed::Fast:     return 2;
+    case WebpSpeed::Balanced: return 4;
+    case WebpSpeed::Smallest: return 6;
+    }
+    return 4;
+}
+
+// Fills picture from img's pixels, converting only layouts libwebp cannot import
+static bool importPixels(const QImage &img, WebPPicture &picture)
+{
+    picture.width = img.width();
+    picture.height = img.height();
+    QImage pixels = img;
+    const int stride = static_cast<int>(pixels.bytesPerLine());
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // QImage's 32-bit formats are BGRA in memory on little-endian machines
+    if (pixels.format() == QImage::Format_RGB32)
+        return WebPPictureImportBGRX(&picture, pixels.constBits(), stride);
+    if (pixels.format() == QImage::Format_ARGB32)
+        return WebPPictureImportBGRA(&picture, pixels.constBits(), stride);
+#endif
+    switch (pixels.format()) {
+    case QImage::Format_RGBX8888:
+        return WebPPictureImportRGBX(&picture, pixels.constBits(), stride);
+    case QImage::Format_RGBA8888:
+        return WebPPictureImportRGBA(&picture, pixels.constBits(), stride);
+    case QImage::Format_RGB888:
+        return WebPPictureImportRGB(&picture, pixels.constBits(), stride);
+    case QImage::Format_BGR888:
+        return WebPPictureImportBGR(&picture, pixels.constBits(), stride);
+    default:
+        break;
+    }
+    pixels = pixels.convertToFormat(pixels.hasAlphaChannel() ? QImage::Format_RGBA8888
+                                                             : QImage::Format_RGBX8888);
+    return pixels.hasAlphaChannel()
+        ? WebPPictureImportRGBA(&picture, pixels.constBits(), static_cast<int>(pixels.bytesPerLine()))
+        : WebPPictureImportRGBX(&picture, pixels.constBits(), static_cast<int>(pixels.bytesPerLine()));
+}
+
+// Memory writer that fails, aborting the encode, once the output would
+// grow past maxBytes
+struct CappedWriter {
+    WebPMemoryWriter memory;
+    qint64 maxBytes = 0;
+    bool overLimit = false;
+};
+
+static int cappedWrite(const uint8_t *data, size_t size, const WebPPicture *picture)
+{
+    auto *writer = static_cast<CappedWriter *>(picture->custom_ptr);
+    if (writer->maxBytes > 0 && qint64(writer->memory.size + size) > writer->maxBytes) {
+        writer->overLimit = true;
+        return 0;
+    }
+    WebPPicture forward = *picture;
+    forward.custom_ptr = &writer->memory;
+    return WebPMemoryWrite(data, size, &forward);
+}
+
+// Wraps a bare VP8/VP8L bitstream in a container with an ICCP chunk
+static QByteArray withIccProfile(const WebPMemoryWriter &encoded, const QByteArray &icc)
+{
+    WebPMux *mux = WebPMuxNew();
+    if (!mux) return {};
+    WebPData image = { encoded.mem, encoded.size };
+    WebPData profile = { reinterpret_cast<const uint8_t *>(icc.constData()), static_cast<size_t>(icc.size()) };
+    WebPData assembled;
+    WebPDataInit(&assembled);
+    QByteArray bytes;
+    if (WebPMuxSetImage(mux, &image, 0) == WEBP_MUX_OK
+        && WebPMuxSetChunk(mux, "ICCP", &profile, 0) == WEBP_MUX_OK
+        && WebPMuxAssemble(mux, &assembled) == WEBP_MUX_OK)
+        bytes = QByteArray(reinterpret_cast<const char *>(assembled.bytes), static_cast<qsizetype>(assembled.size));
+    WebPDataClear(&assembled);
+    WebPMuxDelete(mux);
+    return bytes;
+}
+
+static ResultStatus encodeOnce(const QImage &img, const WebPConfig &config, const QByteArray &icc,
+                               const std::atomic<bool> *cancelFlag, qint64 maxBytes,
+                               QByteArray &data, QString &errorMessage)
+{
+    WebPPicture picture;
+    if (!WebPPictureInit(&picture)) {
+        errorMessage = "Failed to initialise WebP encoder";
+        return ResultStatus::FailedToSave;
+    }
+    // ARGB input suits the lossy encoder's own RGB to YUV conversion
+    picture.use_argb = 1;
+    if (!importPixels(img, picture)) {
+        WebPPictureFree(&picture);
+        errorMessage = "Failed to prepare image for WebP encoding";
+        return ResultStatus::FailedToSave;
+    }
+
+    CappedWriter capped;
+    WebPMemoryWriterInit(&capped.memory);
+    // The profile is added after encoding, so leave room for it
+    capped.maxBytes = (maxBytes > 0) ? qMax<qint64>(1, maxBytes - icc.size()) : 0;
+    const WebPMemoryWriter &writer = capped.memory;
+    picture.writer = cappedWrite;
+    picture.custom_ptr = &capped;
+    picture.progress_hook = webpProgress;
+    picture.user_data = const_cast<std::atomic<bool> *>(cancelFlag);
+
+    ResultStatus status = ResultStatus::Success;
+    if (!WebPEncode(&config, &picture)) {
+        if (picture.error_code == VP8_ENC_ERROR_USER_ABORT) {
+            status = ResultStatus::Cancelled;
+        } else if (capped.overLimit) {
+            status = ResultStatus::KeptOriginal;
+        } else {
+            errorMessage = QString("Failed to encode WebP (error %1)").arg(static_cast<int>(picture.error_code));
+            status = ResultStatus::FailedToSave;
+        }
+    } else if (icc.isEmpty()) {
+        data = QByteArray(reinterpret_cast<const char *>(writer.mem), static_cast<qsizetype>(writer.size));
+    } else {
+        data = withIccProfile(writer, icc);
+        if (data.isEmpty()) {
+            errorMessage = "Failed to write WebP colour profile";
+            status = ResultStatus::FailedToSave;
+        }
+    }
+    WebPMemoryWriterClear(&capped.memory);
+    WebPPictureFree(&picture);
+    return status;
+}
+
+ResultStatus WebpCodec::encode(const QImage &img, const ProcessingSettings &settings, int quality,
+                               qint64 targetBytes, const std::atomic<bool> *cancelFlag,
+                               QByteArray &data, QString &errorMessage, qint64 maxBytes)
+{
+    WebPConfig config;
+    if (!WebPConfigPreset(&config, WEBP_PRESET_DEFAULT, static_cast<float>(quality))) {
+        errorMessage = "Failed to initialise WebP encoder";
+        return ResultStatus::FailedToSave;
+    }
+    config.method = methodFor(settings.webpSpeed);
+    config.thread_level = 1;  // Lets libwebp overlap alpha and analysis work on a helper thread
+    if (settings.webpLossless) {
+        if (!WebPConfigLosslessPreset(&config, losslessLevelFor(settings.webpSpeed))) {
+            errorMessage = "Failed to initialise WebP encoder";
+            return ResultStatus::FailedToSave;
+        }
+        targetBytes = 0;
+    }
+
+    const QByteArray icc = img.colorSpace().isValid() ? img.colorSpace().iccProfile() : QByteArray();
+    if (targetBytes > 0) {
+        // The profile is added after encoding, so leave room for it
+        config.target_size = static_cast<int>(qBound<qint64>(1, targetBytes - icc.size(), INT_MAX));
+        config.pass = TARGET_SIZE_PASSES;
+    }
+    if (!WebPValidateConfig(&config)) {
+        errorMessage = "Invalid WebP encoder settings";
+        return ResultStatus::FailedToSave;
+    }
+
+    ResultStatus status = encodeOnce(img, config, icc, cancelFlag, maxBytes, data, errorMessage);
+    if (status != ResultStatus::Success || targetBytes <= 0 || data.size() <= targetBytes)
+        return status;
+
+    // Rate control converges from both sides and may land just over; aim
+    // lower by the overshoot once and keep whichever result is smaller. The
+    // first result stands whatever happens to the retry, short of a cancel.
+    QByteArray retry;
+    QString retryError;
+    config.target_size = static_cast<int>(qMax<qint64>(1, config.target_size * targetBytes / data.size()));
+    ResultStatus retryStatus = encodeOnce(img, config, icc, cancelFlag, maxBytes, retry, retryError);
+    if (retryStatus == ResultStatus::Cancelled) return retryStatus;
+    if (retryStatus == ResultStatus::Success && retry.size() < data.size())
+        data = retry;
+    return ResultStatus::Success;
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <atomic>
+#include <QByteArray>
+#include <QString>
+
+#include "ProcessingJob.h"
+#include "ProcessingResult.h"
+
+class QImage;
+
+// Native WebP encoder on libwebp. A target size is handed to libwebp's own
+// multi-pass rate control, so one call replaces a search over qualities.
+// Encoding stops part-way once cancelFlag is raised, or with KeptOriginal
+// once the output grows past maxBytes.
+class WebpCodec {
+public:
+    // targetBytes > 0: aim for that size, starting from quality; the result
+    // may still be over it, which callers check. Otherwise encode at quality. settings.webpLossless ignores both. maxBytes <= 0
+    // leaves the output size unlimited.
+    static ResultStatus encode(const QImage &img, const ProcessingSettings &settings, int quality,
+                               qint64 targetBytes, const std::atomic<bool> *cancelFlag,
+                               QByteArray &data, QString &errorMessage, qint64 maxBytes = 0);
+};
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "WorkerProcess.h"
+#include "ImageProcessor.h"
+#include "WorkerProtocol.h"
+#include <atomic>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFuture>
+#include <QMutex>
+#include <QProcess>
+#include <QtConcurrent>
+#include <QtEndian>
+
+static constexpr int START_TIMEOUT_MS = 10000;
+static constexpr int POLL_MS = 50;           // Result wait slice; also bounds cancel forwarding
+static constexpr int STOP_TIMEOUT_MS = 2000;
+static constexpr qint64 READ_CHUNK = 64 * 1024;
+
+WorkerProcess::WorkerProcess() = default;
+
+WorkerProcess::~WorkerProcess()
+{
+    stop();
+}
+
+bool WorkerProcess::ensureStarted(QString &error)
+{
+    if (m_process && m_process->state() == QProcess::Running) return true;
+    m_process = std::make_unique<QProcess>();
+    m_buffer.clear();
+    // Warnings from the child still reach the console
+    m_process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    m_process->start(QCoreApplication::applicationFilePath(), { WORKER_ARGUMENT });
+    if (m_process->waitForStarted(START_TIMEOUT_MS)) return true;
+    error = "Could not start worker process: " + m_process->errorString();
+    m_process.reset();
+    return false;
+}
+
+void WorkerProcess::stop()
+{
+    if (!m_process) return;
+    // Closing stdin tells the child to exit once its current job is done
+    m_process->closeWriteChannel();
+    if (!m_process->waitForFinished(STOP_TIMEOUT_MS)) {
+        m_process->kill();
+        m_process->waitForFinished(STOP_TIMEOUT_MS);
+    }
+    m_process.reset();
+}
+
+ProcessingResult WorkerProcess::process(const ProcessingJob &job)
+{
+    ProcessingResult failure;
+    failure.inputPath = job.inputPath;
+    failure.outputPath = job.outputPath;
+    failure.index = job.index;
+    failure.status = ResultStatus::FailedToLoad;
+
+    if (!ensureStarted(failure.errorMessage)) return failure;
+    m_process->write(WorkerProtocol::encodeJob(job));
+
+    bool cancelSent = false;
+    for (;;) {
+        WorkerProtocol::Message type;
+        QByteArray payload;
+        switch (WorkerProtocol::takeMessage(m_buffer, type, payload)) {
+        case WorkerProtocol::Take::Complete: {
+            ProcessingResult result;
+            if (type == WorkerProtocol::Message::Result && WorkerProtocol::decodeResult(payload, result))
+                return result;
+            [[fallthrough]];
+        }
+        case WorkerProtocol::Take::Corrupt:
+            failure.errorMessage = "Worker process sent an invalid message";
+            m_process->kill();
+            m_process->waitForFinished(STOP_TIMEOUT_MS);
+            m_process.reset();
+            return failure;
+        case WorkerProtocol::Take::Incomplete:
+            break;
+        }
+
+        if (!cancelSent && job.cancelFlag && job.cancelFlag->load(std::memory_order_relaxed)) {
+            m_process->write(WorkerProtocol::encodeCancel());
+            cancelSent = true;
+        }
+        if (m_process->waitForReadyRead(POLL_MS)) {
+            m_buffer += m_process->readAll();
+            continue;
+        }
+        if (m_process->state() != QProcess::Running) {
+            QByteArray rest = m_process->readAll();
+            if (!rest.isEmpty()) {
+                m_buffer += rest;
+                continue;
+            }
+            // The child died on this job; the next job starts a new one
+            failure.errorMessage = m_process->exitStatus() == QProcess::CrashExit
+                ? "Worker process crashed while processing this file"
+                : QString("Worker process exited with code %1").arg(m_process->exitCode());
+            m_process.reset();
+            return failure;
+        }
+    }
+}
+
+// Reads exactly size bytes from a blocking device; false at end of input
+static bool readExactly(QFile &in, char *data, qint64 size)
+{
+    while (size > 0) {
+        qint64 n = in.read(data, qMin(size, READ_CHUNK));
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+int WorkerProcess::serve()
+{
+    QFile in;
+    QFile out;
+    if (!WorkerProtocol::openStandardStreams(in, out)) return 1;
+
+    // The main thread keeps reading so a Cancel can arrive while the job
+    // runs on a pool thread, which then writes its own result
+    std::atomic<bool> cancelled{false};
+    QMutex outMutex;
+    QFuture<void> running;
+    QByteArray buffer;
+    for (;;) {
+        QByteArray header(sizeof(quint32), Qt::Uninitialized);
+        if (!readExactly(in, header.data(), header.size())) break;
+        quint32 size = qFromBigEndian<quint32>(header.constData());
+        if (size == 0 || size > WorkerProtocol::MAX_MESSAGE_SIZE) return 1;
+        buffer = header + QByteArray(size, Qt::Uninitialized);
+        if (!readExactly(in, buffer.data() + header.size(), size)) break;
+
+        WorkerProtocol::Message type;
+        QByteArray payload;
+        if (WorkerProtocol::takeMessage(buffer, type, payload) != WorkerProtocol::Take::Complete) return 1;
+        if (type == WorkerProtocol::Message::Cancel) {
+            cancelled = true;
+            continue;
+        }
+        if (type != WorkerProtocol::Message::Job) return 1;
+
+        ProcessingJob job;
+        if (!WorkerProtocol::decodeJob(payload, job)) return 1;
+        running.waitForFinished();  // The app sends one job at a time
+        cancelled = false;
+        job.cancelFlag = &cancelled;
+        running = QtConcurrent::run([job, &out, &outMutex]() {
+            QByteArray message = WorkerProtocol::encodeResult(ImageProcessor::process(job));
+            QMutexLocker lock(&outMutex);
+            out.write(message);
+            out.flush();
+        });
+    }
+    cancelled = true;
+    running.waitForFinished();
+    return 0;
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <memory>
+#include <QByteArray>
+
+#include "ProcessingJob.h"
+#include "ProcessingResult.h"
+
+class QProcess;
+
+// Runs jobs in a child copy of the app started with --worker, talking
+// WorkerProtocol over its stdin/stdout. A decoder or plugin crash then only
+// takes down the child: the job it was on is reported as failed and the
+// next job starts a fresh child. Each instance belongs to one scheduler
+// thread and blocks it while a job runs.
+class WorkerProcess {
+public:
+    static constexpr const char *WORKER_ARGUMENT = "--worker";
+
+    WorkerProcess();
+    ~WorkerProcess();
+
+    WorkerProcess(const WorkerProcess &) = delete;
+    WorkerProcess &operator=(const WorkerProcess &) = delete;
+
+    // Sends the job to the child and waits for its result. Raising
+    // job.cancelFlag is forwarded to the child.
+    ProcessingResult process(const ProcessingJob &job);
+
+    // Entry point of the child: serves jobs from stdin until it is closed
+    static int serve();
+
+private:
+    bool ensureStarted(QString &error);
+    void stop();
+
+    std::unique_ptr<QProcess> m_process;
+    QByteArray m_buffer;  // Bytes received but not yet parsed
+};
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#include "WorkerProtocol.h"
+#include <cstdio>
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+
+#if defined(Q_OS_WIN)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static constexpr int HEADER_SIZE = sizeof(quint32);
+
+static QByteArray frame(const QByteArray &payload)
+{
+    QByteArray message(HEADER_SIZE, Qt::Uninitialized);
+    qToBigEndian(static_cast<quint32>(payload.size()), message.data());
+    return message + payload;
+}
+
+static QDataStream &operator<<(QDataStream &out, const ProcessingSettings &s)
+{
+    return out << qint32(s.format) << qint32(s.resizeMode) << qint32(s.resizePercent)
+               << qint32(s.resizeWidth) << qint32(s.resizeHeight) << qint32(s.quality)
+               << s.useTargetSize << qint64(s.targetSizeKB)
+               << qint32(s.jpegSubsampling) << s.jpegOptimizeCoding << s.jpegProgressive << s.jpegFastDct
+               << qint32(s.webpSpeed) << qint32(s.avifSpeed) << qint32(s.avifTimeBudgetMs)
+               << qint32(s.passthrough) << s.neverLarger;
+}
+
+static QDataStream &operator>>(QDataStream &in, ProcessingSettings &s)
+{
+    qint32 format, mode, percent, width, height, quality, subsampling, webpSpeed, avifSpeed, avifBudget, passthrough;
+    qint64 targetKB;
+    in >> format >> mode >> percent >> width >> height >> quality >> s.useTargetSize >> targetKB
+       >> subsampling >> s.jpegOptimizeCoding >> s.jpegProgressive >> s.jpegFastDct
+       >> webpSpeed >> avifSpeed >> avifBudget >> passthrough >> s.neverLarger;
+    s.format = static_cast<OutputFormat>(format);
+    s.resizeMode = static_cast<ResizeMode>(mode);
+    s.resizePercent = percent;
+    s.resizeWidth = width;
+    s.resizeHeight = height;
+    s.quality = quality;
+    s.targetSizeKB = targetKB;
+    s.jpegSubsampling = static_cast<JpegSubsampling>(subsampling);
+    s.webpSpeed = static_cast<WebpSpeed>(webpSpeed);
+    s.avifSpeed = static_cast<AvifSpeed>(avifSpeed);
+    s.avifTimeBudgetMs = avifBudget;
+    s.passthrough = static_cast<Passthrough>(passthrough);
+    return in;
+}
+
+QByteArray WorkerProtocol::encodeJob(const ProcessingJob &job)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << quint8(Message::Job) << job.index << job.inputPath << job.outputDir << job.outputPath
+        << qint32(job.decodeThreads) << *job.settings;
+    return frame(payload);
+}
+
+QByteArray WorkerProtocol::encodeCancel()
+{
+    return frame(QByteArray(1, char(Message::Cancel)));
+}
+
+QByteArray WorkerProtocol::encodeResult(const ProcessingResult &r)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << quint8(Message::Result) << r.index << r.inputPath << r.outputPath
+        << r.originalSize << r.newSize
+        << qint32(r.originalWidth) << qint32(r.originalHeight)
+        << qint32(r.newWidth) << qint32(r.newHeight)
+        << qint32(r.status) << r.errorMessage
+        << r.decodeUs << r.resizeUs << r.encodeUs << qint32(r.avifSpeed) << r.passedThrough
+        << qint32(r.format);
+    return frame(payload);
+}
+
+WorkerProtocol::Take WorkerProtocol::takeMessage(QByteArray &buffer, Message &type, QByteArray &payload)
+{
+    if (buffer.size() < HEADER_SIZE) return Take::Incomplete;
+    quint32 size = qFromBigEndian<quint32>(buffer.constData());
+    if (size == 0 || size > MAX_MESSAGE_SIZE) return Take::Corrupt;
+    if (buffer.size() < HEADER_SIZE + qsizetype(size)) return Take::Incomplete;
+    payload = buffer.mid(HEADER_SIZE, size);
+    buffer.remove(0, HEADER_SIZE + size);
+    type = static_cast<Message>(payload.at(0));
+    return Take::Complete;
+}
+
+bool WorkerProtocol::decodeJob(const QByteArray &payload, ProcessingJob &job)
+{
+    QDataStream in(payload);
+    quint8 type;
+    qint32 decodeThreads;
+    auto settings = std::make_shared<ProcessingSettings>();
+    in >> type >> job.index >> job.inputPath >> job.outputDir >> job.outputPath >> decodeThreads >> *settings;
+    if (in.status() != QDataStream::Ok || type != quint8(Message::Job)) return false;
+    job.decodeThreads = decodeThreads;
+    job.settings = std::move(settings);
+    return true;
+}
+
+bool WorkerProtocol::decodeResult(const QByteArray &payload, ProcessingResult &r)
+{
+    QDataStream in(payload);
+    quint8 type;
+    qint32 originalWidth, originalHeight, newWidth, newHeight, status, avifSpeed, format;
+    in >> type >> r.index >> r.inputPath >> r.outputPath >> r.originalSize >> r.newSize
+       >> originalWidth >> originalHeight >> newWidth >> newHeight >> status >> r.errorMessage
+       >> r.decodeUs >> r.resizeUs >> r.encodeUs >> avifSpeed >> r.passedThrough
+       >> format;
+    if (in.status() != QDataStream::Ok || type != quint8(Message::Result)) return false;
+    r.originalWidth = originalWidth;
+    r.originalHeight = originalHeight;
+    r.newWidth = newWidth;
+    r.newHeight = newHeight;
+    r.status = static_cast<ResultStatus>(status);
+    r.avifSpeed = avifSpeed;
+    r.format = static_cast<OutputFormat>(format);
+    return true;
+}
+
+bool WorkerProtocol::openStandardStreams(QFile &in, QFile &out)
+{
+#if defined(Q_OS_WIN)
+    if (_setmode(_fileno(stdin), _O_BINARY) == -1 || _setmode(_fileno(stdout), _O_BINARY) == -1)
+        return false;
+#endif
+    return in.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered)
+        && out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
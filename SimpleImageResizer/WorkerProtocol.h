@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+#pragma once
+
+#include <QByteArray>
+
+#include "ProcessingJob.h"
+#include "ProcessingResult.h"
+
+class QFile;
+class QIODevice;
+
+// Wire format between the app and its worker processes. Each message is a
+// big-endian 32-bit payload length followed by a QDataStream payload whose
+// first byte is the message type. Jobs and results only carry paths,
+// settings and numbers: workers read inputs and write outputs themselves,
+// so no pixels cross the connection. Nothing here depends on the
+// transport; any byte stream (pipes today) can carry it.
+class WorkerProtocol {
+public:
+    enum class Message : quint8 {
+        Job = 1,     // app -> worker
+        Cancel = 2,  // app -> worker: abandon the current job
+        Result = 3   // worker -> app
+    };
+
+    enum class Take { Incomplete, Complete, Corrupt };
+
+    static QByteArray encodeJob(const ProcessingJob &job);
+    static QByteArray encodeCancel();
+    static QByteArray encodeResult(const ProcessingResult &result);
+
+    // Removes one complete message from the front of buffer. Corrupt means
+    // the stream is unusable and the connection should be dropped.
+    static Take takeMessage(QByteArray &buffer, Message &type, QByteArray &payload);
+
+    // job.settings is set to a fresh copy; cancelFlag and limiter are untouched
+    static bool decodeJob(const QByteArray &payload, ProcessingJob &job);
+    static bool decodeResult(const QByteArray &payload, ProcessingResult &result);
+
+    // Opens the process's stdin and stdout for the pipe transport, in binary
+    // mode so Windows does not translate line endings or stop at Ctrl+Z
+    static bool openStandardStreams(QFile &in, QFile &out);
+
+    static constexpr quint32 MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+};
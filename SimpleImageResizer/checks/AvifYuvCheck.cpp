@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+// Checks that libavif's libyuv fast path converts between RGB and YUV
+// within a small tolerance of its scalar code, for the layouts AvifCodec
+// uses: 8-bit BGRA, with and without alpha, at 4:2:0 and 4:4:4 with the
+// default matrix and range. Returns non-zero on a mismatch.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <avif/avif.h>
+
+static constexpr uint32_t WIDTH = 333;   // Odd, so the last chroma column and row are partial
+static constexpr uint32_t HEIGHT = 217;
+static constexpr int MAX_DIFF = 4;       // Per sample; fixed-point against float coefficients
+static constexpr double MAX_MEAN_DIFF = 1.0;
+
+// Gradients, hard edges and noise, so rounding and chroma siting both show
+static void fillFixture(avifRGBImage &rgb, bool alpha)
+{
+    uint32_t seed = 12345;
+    for (uint32_t y = 0; y < rgb.height; ++y) {
+        uint8_t *row = rgb.pixels + size_t(y) * rgb.rowBytes;
+        for (uint32_t x = 0; x < rgb.width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = int(seed >> 28) - 8;
+            const bool edge = ((x / 16) + (y / 16)) % 2 == 0;
+            uint8_t *px = row + 4 * x;
+            px[0] = uint8_t(std::abs(int(x * 255 / WIDTH) + noise) % 256);    // B
+            px[1] = uint8_t(edge ? 230 : 20);                                 // G
+            px[2] = uint8_t(std::abs(int(y * 255 / HEIGHT) - noise) % 256);   // R
+            px[3] = alpha ? uint8_t((x + y) * 255 / (WIDTH + HEIGHT)) : 255;  // A
+        }
+    }
+}
+
+struct Diff {
+    int max = 0;
+    double mean = 0.0;
+};
+
+static Diff compare(const uint8_t *a, uint32_t aRowBytes, const uint8_t *b, uint32_t bRowBytes,
+                    uint32_t width, uint32_t height)
+{
+    Diff diff;
+    double total = 0.0;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const int d = std::abs(int(a[size_t(y) * aRowBytes + x]) - int(b[size_t(y) * bRowBytes + x]));
+            if (d > diff.max) diff.max = d;
+            total += d;
+        }
+    }
+    diff.mean = (width && height) ? total / (double(width) * height) : 0.0;
+    return diff;
+}
+
+static bool report(const char *what, const Diff &diff)
+{
+    const bool ok = diff.max <= MAX_DIFF && diff.mean <= MAX_MEAN_DIFF;
+    std::printf("%-34s max %d mean %.3f %s\n", what, diff.max, diff.mean, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static avifImage *toYuv(const avifRGBImage &source, avifPixelFormat format, bool avoidLibYUV)
+{
+    avifImage *image = avifImageCreate(WIDTH, HEIGHT, 8, format);
+    if (!image) return nullptr;
+    avifRGBImage rgb = source;
+    rgb.avoidLibYUV = avoidLibYUV ? AVIF_TRUE : AVIF_FALSE;
+    if (avifImageRGBToYUV(image, &rgb) != AVIF_RESULT_OK) {
+        avifImageDestroy(image);
+        return nullptr;
+    }
+    return image;
+}
+
+static bool toRgb(const avifImage *image, bool alpha, bool avoidLibYUV, avifRGBImage &rgb)
+{
+    avifRGBImageSetDefaults(&rgb, image);
+    rgb.format = AVIF_RGB_FORMAT_BGRA;
+    rgb.depth = 8;
+    rgb.ignoreAlpha = alpha ? AVIF_FALSE : AVIF_TRUE;
+    rgb.avoidLibYUV = avoidLibYUV ? AVIF_TRUE : AVIF_FALSE;
+    return avifRGBImageAllocatePixels(&rgb) == AVIF_RESULT_OK
+        && avifImageYUVToRGB(image, &rgb) == AVIF_RESULT_OK;
+}
+
+static bool checkLayout(avifPixelFormat format, bool alpha)
+{
+    const char *name = format == AVIF_PIXEL_FORMAT_YUV420 ? "4:2:0" : "4:4:4";
+    const char *layout = alpha ? "BGRA" : "BGRX";
+
+    avifImage *reference = avifImageCreate(WIDTH, HEIGHT, 8, format);
+    avifRGBImage source;
+    avifRGBImageSetDefaults(&source, reference);
+    source.format = AVIF_RGB_FORMAT_BGRA;
+    source.depth = 8;
+    source.ignoreAlpha = alpha ? AVIF_FALSE : AVIF_TRUE;
+    bool ok = avifRGBImageAllocatePixels(&source) == AVIF_RESULT_OK;
+    avifImageDestroy(reference);
+    if (!ok) {
+        std::printf("%s %s: cannot allocate the fixture\n", layout, name);
+        return false;
+    }
+    fillFixture(source, alpha);
+
+    avifImage *fast = toYuv(source, format, false);
+    avifImage *scalar = toYuv(source, format, true);
+    avifRGBImage fastRgb{};
+    avifRGBImage scalarRgb{};
+    if (!fast || !scalar || !toRgb(scalar, alpha, false, fastRgb) || !toRgb(scalar, alpha, true, scalarRgb)) {
+        std::printf("%s %s: conversion failed\n", layout, name);
+        ok = false;
+    } else {
+        char what[64];
+        const char *planes[] = { "Y", "U", "V" };
+        for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_V; ++c) {
+            std::snprintf(what, sizeof(what), "%s %s RGB->YUV %s", layout, name, planes[c]);
+            ok &= report(what, compare(avifImagePlane(fast, c), avifImagePlaneRowBytes(fast, c),
+                                       avifImagePlane(scalar, c), avifImagePlaneRowBytes(scalar, c),
+                                       avifImagePlaneWidth(fast, c), avifImagePlaneHeight(fast, c)));
+        }
+        // Every byte of every pixel, alpha included
+        std::snprintf(what, sizeof(what), "%s %s YUV->RGB", layout, name);
+        ok &= report(what, compare(fastRgb.pixels, fastRgb.rowBytes, scalarRgb.pixels, scalarRgb.rowBytes,
+                                   WIDTH * 4, HEIGHT));
+    }
+
+    avifRGBImageFreePixels(&fastRgb);
+    avifRGBImageFreePixels(&scalarRgb);
+    avifRGBImageFreePixels(&source);
+    if (fast) avifImageDestroy(fast);
+    if (scalar) avifImageDestroy(scalar);
+    return ok;
+}
+
+int main()
+{
+    std::printf("libyuv %u\n", avifLibYUVVersion());
+    bool ok = true;
+    for (avifPixelFormat format : { AVIF_PIXEL_FORMAT_YUV420, AVIF_PIXEL_FORMAT_YUV444 }) {
+        ok &= checkLayout(format, false);
+        ok &= checkLayout(format, true);
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (C) 2024-2026 thanolion
+
+// Checks that jobs and results survive a WorkerProtocol round trip, that
+// messages split across reads are reassembled, and that a bad length
+// header is reported as corrupt. The stream is then sent through a child
+// copy of this check, which echoes every message back over its stdin and
+// stdout like a worker does, so text-mode pipes show up as a mismatch.
+// Returns non-zero on a mismatch.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <QCoreApplication>
+#include <QFile>
+#include <QList>
+#include <QProcess>
+#include <QtEndian>
+
+#include "WorkerProtocol.h"
+
+static constexpr qsizetype CHUNK = 7;  // Odd, so headers and payloads both arrive split
+static constexpr const char *ECHO_ARGUMENT = "--echo";
+static constexpr int CHILD_TIMEOUT_MS = 30000;
+
+static bool s_ok = true;
+
+// Child side: decodes each message from stdin and writes it back re-encoded
+static int echo()
+{
+    QFile in;
+    QFile out;
+    if (!WorkerProtocol::openStandardStreams(in, out)) return EXIT_FAILURE;
+    QByteArray buffer;
+    for (;;) {
+        QByteArray chunk = in.read(CHUNK);
+        if (chunk.isEmpty()) break;
+        buffer += chunk;
+        for (;;) {
+            WorkerProtocol::Message type;
+            QByteArray payload;
+            WorkerProtocol::Take take = WorkerProtocol::takeMessage(buffer, type, payload);
+            if (take == WorkerProtocol::Take::Incomplete) break;
+            if (take == WorkerProtocol::Take::Corrupt) return EXIT_FAILURE;
+            ProcessingJob job;
+            ProcessingResult result;
+            if (type == WorkerProtocol::Message::Job && WorkerProtocol::decodeJob(payload, job))
+                out.write(WorkerProtocol::encodeJob(job));
+            else if (type == WorkerProtocol::Message::Result && WorkerProtocol::decodeResult(payload, result))
+                out.write(WorkerProtocol::encodeResult(result));
+            else if (type == WorkerProtocol::Message::Cancel)
+                out.write(WorkerProtocol::encodeCancel());
+            else
+                return EXIT_FAILURE;
+        }
+    }
+    out.flush();
+    return buffer.isEmpty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void check(bool condition, const char *what)
+{
+    std::printf("%-40s %s\n", what, condition ? "ok" : "FAILED");
+    s_ok = s_ok && condition;
+}
+
+// Non-default values everywhere, so a dropped or reordered field shows
+static ProcessingJob makeJob()
+{
+    auto settings = std::make_shared<ProcessingSettings>();
+    settings->format = OutputFormat::Auto;
+    settings->resizeMode = ResizeMode::FitBoundingBox;
+    settings->resizePercent = 42;
+    settings->resizeWidth = 1920;
+    settings->resizeHeight = 1080;
+    settings->quality = 73;
+    settings->useTargetSize = true;
+    settings->targetSizeKB = 3LL * 1024 * 1024;
+    settings->jpegSubsampling = JpegSubsampling::Yuv444;
+    settings->jpegOptimizeCoding = false;
+    settings->jpegProgressive = true;
+    settings->jpegFastDct = true;
+    settings->webpSpeed = WebpSpeed::Smallest;
+    settings->avifSpeed = AvifSpeed::Best;
+    settings->avifTimeBudgetMs = 1500;
+    settings->passthrough = Passthrough::Link;
+    settings->neverLarger = true;
+
+    ProcessingJob job;
+    job.inputPath = QString::fromUtf8("/photos/\xc3\xa9t\xc3\xa9 2024/IMG_0001.CR3");
+    job.outputDir = "/photos/resized";
+    job.outputPath = "/photos/resized/IMG_0001.avif";
+    job.settings = settings;
+    job.decodeThreads = 3;
+    job.index = 5000000000LL;
+    return job;
+}
+
+static ProcessingResult makeResult()
+{
+    ProcessingResult r;
+    r.inputPath = "/photos/IMG_0002.png";
+    r.outputPath = "/photos/resized/IMG_0002.webp";
+    r.originalSize = 6LL * 1024 * 1024 * 1024;
+    r.newSize = 123456;
+    r.originalWidth = 8000;
+    r.originalHeight = 6000;
+    r.newWidth = 1600;
+    r.newHeight = 1200;
+    r.status = ResultStatus::KeptOriginal;
+    r.errorMessage = "kept";
+    r.index = 17;
+    r.decodeUs = 1111;
+    r.resizeUs = 2222;
+    r.encodeUs = 3333;
+    r.format = OutputFormat::WebP;
+    r.avifSpeed = 8;
+    r.passedThrough = true;
+    return r;
+}
+
+static void checkJob(const ProcessingJob &a, const ProcessingJob &b)
+{
+    check(a.inputPath == b.inputPath && a.outputDir == b.outputDir && a.outputPath == b.outputPath,
+          "job paths");
+    check(a.decodeThreads == b.decodeThreads && a.index == b.index, "job threads and index");
+    check(b.settings && b.settings != a.settings, "job settings are a fresh copy");
+    if (!b.settings) return;
+    const ProcessingSettings &s = *a.settings;
+    const ProcessingSettings &t = *b.settings;
+    check(s.format == t.format && s.resizeMode == t.resizeMode && s.resizePercent == t.resizePercent
+          && s.resizeWidth == t.resizeWidth && s.resizeHeight == t.resizeHeight,
+          "settings format and size");
+    check(s.quality == t.quality && s.useTargetSize == t.useTargetSize && s.targetSizeKB == t.targetSizeKB,
+          "settings quality and target");
+    check(s.jpegSubsampling == t.jpegSubsampling && s.jpegOptimizeCoding == t.jpegOptimizeCoding
+          && s.jpegProgressive == t.jpegProgressive && s.jpegFastDct == t.jpegFastDct,
+          "settings JPEG options");
+    check(s.webpSpeed == t.webpSpeed && s.avifSpeed == t.avifSpeed && s.avifTimeBudgetMs == t.avifTimeBudgetMs,
+          "settings WebP and AVIF options");
+    check(s.passthrough == t.passthrough && s.neverLarger == t.neverLarger, "settings passthrough");
+}
+
+static void checkResult(const ProcessingResult &a, const ProcessingResult &b)
+{
+    check(a.inputPath == b.inputPath && a.outputPath == b.outputPath && a.index == b.index,
+          "result paths and index");
+    check(a.originalSize == b.originalSize && a.newSize == b.newSize, "result sizes");
+    check(a.originalWidth == b.originalWidth && a.originalHeight == b.originalHeight
+          && a.newWidth == b.newWidth && a.newHeight == b.newHeight,
+          "result dimensions");
+    check(a.status == b.status && a.errorMessage == b.errorMessage, "result status");
+    check(a.decodeUs == b.decodeUs && a.resizeUs == b.resizeUs && a.encodeUs == b.encodeUs,
+          "result timings");
+    check(a.format == b.format && a.avifSpeed == b.avifSpeed && a.passedThrough == b.passedThrough,
+          "result format and passthrough");
+}
+
+// Sends stream through a child echo and returns what came back
+static QByteArray echoThroughChild(const QByteArray &stream, int &exitCode)
+{
+    QProcess child;
+    child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    child.start(QCoreApplication::applicationFilePath(), { ECHO_ARGUMENT });
+    if (!child.waitForStarted(CHILD_TIMEOUT_MS)) return {};
+    child.write(stream);
+    child.closeWriteChannel();
+    child.waitForFinished(CHILD_TIMEOUT_MS);
+    exitCode = child.exitStatus() == QProcess::NormalExit ? child.exitCode() : -1;
+    return child.readAllStandardOutput();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], ECHO_ARGUMENT) == 0)
+        return echo();
+    QCoreApplication app(argc, argv);
+
+    const ProcessingJob job = makeJob();
+    const ProcessingResult result = makeResult();
+    const QByteArray stream = WorkerProtocol::encodeJob(job) + WorkerProtocol::encodeCancel()
+                            + WorkerProtocol::encodeResult(result);
+
+    // Feed the stream a few bytes at a time, as a pipe read might deliver it
+    QByteArray buffer;
+    QList<WorkerProtocol::Message> types;
+    QList<QByteArray> payloads;
+    bool corrupt = false;
+    for (qsizetype pos = 0; pos < stream.size() && !corrupt; pos += CHUNK) {
+        buffer += stream.mid(pos, CHUNK);
+        for (;;) {
+            WorkerProtocol::Message type;
+            QByteArray payload;
+            WorkerProtocol::Take take = WorkerProtocol::takeMessage(buffer, type, payload);
+            if (take == WorkerProtocol::Take::Incomplete) break;
+            if (take == WorkerProtocol::Take::Corrupt) {
+                corrupt = true;
+                break;
+            }
+            types.append(type);
+            payloads.append(payload);
+        }
+    }
+    check(!corrupt && buffer.isEmpty(), "split stream fully consumed");
+    check(types == QList<WorkerProtocol::Message>{ WorkerProtocol::Message::Job, WorkerProtocol::Message::Cancel,
+                                                   WorkerProtocol::Message::Result },
+          "message order");
+
+    if (types.size() == 3) {
+        ProcessingJob decodedJob;
+        check(WorkerProtocol::decodeJob(payloads[0], decodedJob), "job decodes");
+        checkJob(job, decodedJob);
+
+        ProcessingResult decodedResult;
+        check(WorkerProtocol::decodeResult(payloads[2], decodedResult), "result decodes");
+        checkResult(result, decodedResult);
+
+        ProcessingResult wrongType;
+        check(!WorkerProtocol::decodeResult(payloads[0], wrongType), "job payload rejected as result");
+        check(!WorkerProtocol::decodeJob(payloads[0].left(payloads[0].size() / 2), decodedJob),
+              "truncated payload rejected");
+    }
+
+    // A zero or oversized length can never become a message
+    for (quint32 size : { 0u, WorkerProtocol::MAX_MESSAGE_SIZE + 1 }) {
+        QByteArray bad(sizeof(quint32), Qt::Uninitialized);
+        qToBigEndian(size, bad.data());
+        WorkerProtocol::Message type;
+        QByteArray payload;
+        check(WorkerProtocol::takeMessage(bad, type, payload) == WorkerProtocol::Take::Corrupt,
+              size ? "oversized length is corrupt" : "zero length is corrupt");
+    }
+
+    // Line feeds, carriage returns and Ctrl+Z in lengths and payloads are
+    // what a text-mode pipe would mangle or stop at
+    ProcessingJob awkward = makeJob();
+    awkward.inputPath = QString("line\nfeed\r\nand \x1a stop");
+    awkward.index = 0x0A1A0D0A;
+    ProcessingResult awkwardResult = makeResult();
+    awkwardResult.errorMessage = QString(0x0A0D, QChar(0x1A0A));
+    awkwardResult.newSize = 0x1A0A0D1A;
+    const QByteArray awkwardStream = WorkerProtocol::encodeJob(awkward) + WorkerProtocol::encodeCancel()
+                                   + WorkerProtocol::encodeResult(awkwardResult);
+    int exitCode = -1;
+    const QByteArray echoed = echoThroughChild(awkwardStream, exitCode);
+    check(exitCode == EXIT_SUCCESS, "child echo exited cleanly");
+    check(echoed == awkwardStream, "stream unchanged through child pipes");
+
+    return s_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}